@@ -10,6 +10,8 @@
 #include <MNN/Tensor.hpp>
 #include <MNN/ImageProcess.hpp>
 
+#include "mei/image_io_opencv.h"
+
 // --- Helper Functions ---
 template <typename T>
 std::vector<T> softmax(const T* data, size_t size) {
@@ -45,7 +47,8 @@ int main(int argc, char **argv) {
     auto session = net->createSession(config);
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
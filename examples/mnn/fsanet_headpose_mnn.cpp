@@ -2,15 +2,19 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstring>
 #include <opencv2/opencv.hpp>
 #include <MNN/Interpreter.hpp>
 #include <MNN/Tensor.hpp>
-#include <MNN/ImageProcess.hpp>
 
-// Helper function to run inference on a single model
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
+// Helper function to run inference on a single model. Both models take the
+// same 1x3x64x64 input, preprocessed once by the caller.
 void run_fsanet_model(
     MNN::Interpreter* net,
-    const cv::Mat& img,
+    const std::vector<float>& input,
     float& yaw, float& pitch, float& roll)
 {
     // --- Session and tensor setup ---
@@ -20,38 +24,12 @@ void run_fsanet_model(
     auto input_tensor = net->getSessionInput(session, nullptr);
     const int input_size = 64;
 
-    // --- Preprocessing ---
-    // 1. Padding
-    const float pad = 0.3f;
-    const int h = img.rows;
-    const int w = img.cols;
-    const int nh = static_cast<int>(static_cast<float>(h) + pad * static_cast<float>(h));
-    const int nw = static_cast<int>(static_cast<float>(w) + pad * static_cast<float>(w));
-    const int nx1 = std::max(0, static_cast<int>((nw - w) / 2));
-    const int ny1 = std::max(0, static_cast<int>((nh - h) / 2));
-
-    cv::Mat padded_image = cv::Mat(nh, nw, CV_8UC3, cv::Scalar(0, 0, 0));
-    img.copyTo(padded_image(cv::Rect(nx1, ny1, w, h)));
-    
-    // 2. Resize
-    cv::Mat resized;
-    cv::resize(padded_image, resized, cv::Size(input_size, input_size));
-
     net->resizeTensor(input_tensor, {1, 3, input_size, input_size});
     net->resizeSession(session);
 
-    // 3. Normalize
-    MNN::CV::ImageProcess::Config p_config;
-    p_config.sourceFormat = MNN::CV::BGR;
-    p_config.destFormat = MNN::CV::BGR;
-    p_config.mean[0] = 127.5f;
-    p_config.mean[1] = 127.5f;
-    p_config.mean[2] = 127.5f;
-    p_config.normal[0] = 1.0 / 127.5f;
-    p_config.normal[1] = 1.0 / 127.5f;
-    p_config.normal[2] = 1.0 / 127.5f;
-    std::shared_ptr<MNN::CV::ImageProcess> pretreat(MNN::CV::ImageProcess::create(p_config));
-    pretreat->convert(resized.data, input_size, input_size, resized.step[0], input_tensor);
+    MNN::Tensor input_host(input_tensor, MNN::Tensor::CAFFE);
+    std::memcpy(input_host.host<float>(), input.data(), input.size() * sizeof(float));
+    input_tensor->copyFromHostTensor(&input_host);
 
     // --- Inference ---
     net->runSession(session);
@@ -77,7 +55,8 @@ int main(int argc, char **argv) {
     std::string conv_model_path = argv[2];
     std::string image_path = argv[3];
 
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 64, 64);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
@@ -86,11 +65,29 @@ int main(int argc, char **argv) {
     auto var_net = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(var_model_path.c_str()));
     auto conv_net = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(conv_model_path.c_str()));
 
+    // --- Preprocessing, shared by both models ---
+    // 30% zero padding around the face, resized to 64x64 and normalized in
+    // one pass: the padded canvas is never built, pixels outside the image
+    // read as zero.
+    const int input_size = 64;
+    const float pad = 0.3f;
+    const int nh = static_cast<int>(static_cast<float>(img.rows) + pad * static_cast<float>(img.rows));
+    const int nw = static_cast<int>(static_cast<float>(img.cols) + pad * static_cast<float>(img.cols));
+    const float mean[3] = {127.5f, 127.5f, 127.5f};
+    const float norm[3] = {1.0f / 127.5f, 1.0f / 127.5f, 1.0f / 127.5f};
+    std::vector<float> input(3 * input_size * input_size);
+    const mei::TensorView dst = mei::TensorView::dense(input.data(), {1, 3, input_size, input_size},
+                                                       mei::DataType::Float32, mei::Layout::NCHW);
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::BGR};
+    mei::InputTransform transform;
+    mei::crop_normalize(view, -(nw - img.cols) / 2, -(nh - img.rows) / 2, nw, nh, mei::PixelFormat::BGR,
+                        mean, norm, dst, transform);
+
     float var_yaw, var_pitch, var_roll;
     float conv_yaw, conv_pitch, conv_roll;
 
-    run_fsanet_model(var_net.get(), img, var_yaw, var_pitch, var_roll);
-    run_fsanet_model(conv_net.get(), img, conv_yaw, conv_pitch, conv_roll);
+    run_fsanet_model(var_net.get(), input, var_yaw, var_pitch, var_roll);
+    run_fsanet_model(conv_net.get(), input, conv_yaw, conv_pitch, conv_roll);
     
     // Average the results
     float final_yaw = (var_yaw + conv_yaw) / 2.0f;
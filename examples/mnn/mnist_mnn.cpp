@@ -4,11 +4,15 @@
 #include <numeric>
 #include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include <opencv2/opencv.hpp>
 #include <MNN/Interpreter.hpp>
 #include <MNN/Tensor.hpp>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 // Softmax function
 template <typename T>
 static void softmax(T& input) {
@@ -33,15 +37,15 @@ int main(int argc, char* argv[]) {
     std::string image_path = argv[2]; 
 
     // 2. Load and Preprocess Image
-    cv::Mat img = cv::imread(image_path, cv::IMREAD_GRAYSCALE);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 28, 28, cv::IMREAD_GRAYSCALE);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
 
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(28, 28));
-    
+    const int input_size = 28;
+
     // 3. MNN Session Setup
     auto net = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(model_path.c_str()));
     MNN::ScheduleConfig config;
@@ -50,21 +54,29 @@ int main(int argc, char* argv[]) {
 
     // 4. Define and Fill Input Tensor
     auto input_tensor = net->getSessionInput(session, nullptr);
-    std::vector<int> dims{1, 1, 28, 28};
+    std::vector<int> dims{1, 1, input_size, input_size};
     net->resizeTensor(input_tensor, dims);
     net->resizeSession(session);
     
-    std::vector<float> input_tensor_values(28 * 28);
-    for (int i = 0; i < resized.rows; i++) {
-        for (int j = 0; j < resized.cols; j++) {
-            // Normalize pixel values to [0, 1] and handle potential color inversion needed by model
-            input_tensor_values[i * resized.cols + j] = resized.at<uchar>(i, j) / 255.0f;
-        }
+    // Write the normalized pixels straight into the session tensor when it is
+    // a plain NCHW host buffer; other backends / layouts go through a host copy.
+    std::unique_ptr<MNN::Tensor> host_tensor;
+    float* input_ptr = input_tensor->host<float>();
+    if (!input_ptr || input_tensor->getDimensionType() != MNN::Tensor::CAFFE) {
+        host_tensor.reset(new MNN::Tensor(input_tensor, MNN::Tensor::CAFFE));
+        input_ptr = host_tensor->host<float>();
+    }
+    // Resize and scale to [0, 1] in one single channel pass, no resized
+    // image in between.
+    const float mean[1] = {0.f};
+    const float norm[1] = {1.f / 255.f};
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::Gray};
+    mei::resize_normalize(view, mei::PixelFormat::Gray, mean, norm,
+                          mei::TensorView::dense(input_ptr, {1, 1, input_size, input_size}, mei::DataType::Float32,
+                                                 mei::Layout::NCHW));
+    if (host_tensor) {
+        input_tensor->copyFromHostTensor(host_tensor.get());
     }
-    // Create a temporary host tensor and copy data to the device tensor
-    auto tmp_input_tensor = MNN::Tensor(input_tensor, MNN::Tensor::CAFFE);
-    memcpy(tmp_input_tensor.host<float>(), input_tensor_values.data(), input_tensor_values.size() * sizeof(float));
-    input_tensor->copyFromHostTensor(&tmp_input_tensor);
 
     // 5. Run Inference
     net->runSession(session);
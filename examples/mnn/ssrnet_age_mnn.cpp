@@ -6,6 +6,8 @@
 #include <MNN/Tensor.hpp>
 #include <MNN/ImageProcess.hpp>
 
+#include "mei/image_io_opencv.h"
+
 int main(int argc, char **argv) {
     if (argc < 3) {
         std::cerr << "Usage: " << argv[0] << " <model_path> <image_path>" << std::endl;
@@ -13,7 +15,8 @@ int main(int argc, char **argv) {
     }
     std::string model_path = argv[1];
     std::string image_path = argv[2];
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 64, 64);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
@@ -4,50 +4,11 @@
 #include <opencv2/opencv.hpp>
 #include <MNN/Interpreter.hpp>
 #include <MNN/Tensor.hpp>
-#include <MNN/ImageProcess.hpp>
 #include <algorithm>
+#include <memory>
 
-struct Object {
-    cv::Rect_<float> rect;
-    int label;
-    float prob;
-};
-
-static void nms_sorted_bboxes(std::vector<Object>& objects, std::vector<int>& picked, float nms_threshold, bool agnostic = false)
-{
-    picked.clear();
-    const size_t n = objects.size();
-    std::vector<float> areas(n);
-    for (size_t i = 0; i < n; i++) {
-        areas[i] = objects[i].rect.area();
-    }
-
-    for (size_t i = 0; i < n; i++) {
-        const Object& a = objects[i];
-        int keep = 1;
-        for (size_t j = 0; j < picked.size(); j++) {
-            const Object& b = objects[picked[j]];
-            if (!agnostic && a.label != b.label) {
-                continue;
-            }
-            // intersection over union
-            cv::Rect_<float> inter = a.rect & b.rect;
-            float inter_area = inter.area();
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            float iou = inter_area / union_area;
-            if (iou > nms_threshold)
-            {
-                keep = 0;
-                break;
-            }
-        }
-
-        if (keep) {
-            picked.push_back(i);
-        }
-    }
-}
-
+#include "mei/detection_postprocess.h"
+#include "mei/image_preprocess.h"
 
 int main(int argc, char **argv) {
     if (argc < 3) {
@@ -68,38 +29,26 @@ int main(int argc, char **argv) {
     auto session = net->createSession(config);
     // 输入尺寸
     const int target_size = 640;
-    // letterbox resize
-    int w = img.cols;
-    int h = img.rows;
-    float scale = std::min(target_size / (w*1.f), target_size / (h*1.f));
-    int new_w = w * scale;
-    int new_h = h * scale;
-    
-    int dw = (target_size - new_w) / 2;
-    int dh = (target_size - new_h) / 2;
-
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(new_w, new_h));
-    cv::Mat input_mat = cv::Mat(target_size, target_size, CV_8UC3, cv::Scalar(114, 114, 114));
-    resized.copyTo(input_mat(cv::Rect(dw, dh, new_w, new_h)));
-
-    // BGR to RGB
-    cv::cvtColor(input_mat, input_mat, cv::COLOR_BGR2RGB);
-
-    // 填充 MNN 输入
     auto input_tensor = net->getSessionInput(session, nullptr);
     net->resizeTensor(input_tensor, {1, 3, target_size, target_size});
     net->resizeSession(session);
 
-    MNN::CV::ImageProcess::Config p_config;
-    p_config.sourceFormat = MNN::CV::BGR;
-    p_config.destFormat = MNN::CV::RGB;
-    p_config.filterType = MNN::CV::BICUBIC;
-    p_config.normal[0] = 1.0 / 255.0f;
-    p_config.normal[1] = 1.0 / 255.0f;
-    p_config.normal[2] = 1.0 / 255.0f;
-    std::shared_ptr<MNN::CV::ImageProcess> pretreat(MNN::CV::ImageProcess::create(p_config));
-    pretreat->convert(input_mat.data, target_size, target_size, input_mat.step[0], input_tensor);
+    // letterbox：缩放到 114 填充的画布、BGR -> RGB、除以 255 一次完成；
+    // 会话张量是 NCHW 主机内存时直接写入，否则经临时主机张量拷贝
+    std::unique_ptr<MNN::Tensor> host_tensor;
+    float* input_ptr = input_tensor->host<float>();
+    if (!input_ptr || input_tensor->getDimensionType() != MNN::Tensor::CAFFE) {
+        host_tensor.reset(new MNN::Tensor(input_tensor, MNN::Tensor::CAFFE));
+        input_ptr = host_tensor->host<float>();
+    }
+    const float mean[3] = {0.f, 0.f, 0.f};
+    const float norm[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::BGR};
+    const mei::InputTransform letterbox = mei::letterbox_normalize(view, target_size, target_size,
+        mei::PixelFormat::RGB, mean, norm, 114.f, mei::Layout::NCHW, input_ptr);
+    if (host_tensor) {
+        input_tensor->copyFromHostTensor(host_tensor.get());
+    }
 
     net->runSession(session);
     auto output_tensor = net->getSessionOutput(session, "pred");
@@ -110,72 +59,34 @@ int main(int argc, char **argv) {
     MNN::Tensor output_host(output_tensor, output_tensor->getDimensionType());
     output_tensor->copyToHostTensor(&output_host);
     
-    std::vector<Object> proposals;
     const float* outptr = output_host.host<float>();
     int num_proposal = output_host.shape()[1];
     int num_class = output_host.shape()[2] - 5;
     
     float conf_threshold = 0.25f;
     float nms_threshold = 0.45f;
-
-    for (int i = 0; i < num_proposal; i++)
-    {
-        const float* p = outptr + i * (num_class + 5);
-        float box_score = p[4];
-        if (box_score > conf_threshold)
-        {
-            int class_idx = std::max_element(p + 5, p + 5 + num_class) - (p + 5);
-            float class_score = p[5 + class_idx];
-            float confidence = box_score * class_score;
-
-            if (confidence > conf_threshold)
-            {
-                float cx = p[0];
-                float cy = p[1];
-                float ww = p[2];
-                float hh = p[3];
-
-                float x0 = (cx - ww * 0.5f - dw) / scale;
-                float y0 = (cy - hh * 0.5f - dh) / scale;
-                float x1 = (cx + ww * 0.5f - dw) / scale;
-                float y1 = (cy + hh * 0.5f - dh) / scale;
-                
-                Object obj;
-                obj.rect = cv::Rect_<float>(x0, y0, x1 - x0, y1 - y0);
-                obj.label = class_idx;
-                obj.prob = confidence;
-                proposals.push_back(obj);
-            }
-        }
-    }
-    std::sort(proposals.begin(), proposals.end(), [](const Object& a, const Object& b) {
-        return a.prob > b.prob;
-    });
-
-    std::vector<int> picked;
-    nms_sorted_bboxes(proposals, picked, nms_threshold);
+    int max_detections = 300;
+
+    // Objectness is scanned first (SIMD); class argmax and box transform run
+    // only for the rows that pass it.
+    mei::DetectionBuffer candidates;
+    mei::decode_yolov5(outptr, num_proposal, num_class, conf_threshold, letterbox, candidates);
+    // Class aware NMS on the SoA candidates: at most max_detections survivors,
+    // best first; only as many candidates as needed are ranked.
+    std::vector<mei::Detection> detections;
+    mei::nms(candidates, nms_threshold, false, detections, max_detections);
     
-    if (picked.size() > 0) {
+    if (detections.size() > 0) {
         printf("DEBUG MNN: Detected %zu objects. Top detection: Label %d, Score %.4f\n", 
-               picked.size(), proposals[picked[0]].label, proposals[picked[0]].prob);
+               detections.size(), detections[0].label, detections[0].score);
     }
 
-    if (picked.size() > 0 && proposals[picked[0]].prob > 0.5f) {
+    if (detections.size() > 0 && detections[0].score > 0.5f) {
         printf("true\n");
     } else {
         printf("false\n");
-        // Debugging: Print proposals before NMS if nothing was picked
-        if (picked.empty()) {
-            if (proposals.size() > 0) {
-                printf("DEBUG MNN: No objects picked by NMS. Top 5 proposals before NMS:\n");
-                for (size_t i = 0; i < std::min((size_t)5, proposals.size()); ++i) {
-                    const auto& obj = proposals[i];
-                    printf("  - Label: %d, Prob: %.4f, Rect: [%.2f, %.2f, %.2f, %.2f]\n",
-                        obj.label, obj.prob, obj.rect.x, obj.rect.y, obj.rect.width, obj.rect.height);
-                }
-            } else {
-                printf("DEBUG MNN: No proposals generated at all.\n");
-            }
+        if (detections.empty()) {
+            printf("DEBUG MNN: No proposals generated at all.\n");
         }
     }
     return 0;
@@ -7,6 +7,8 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+
 // A simple softmax implementation
 template <typename T>
 std::vector<T> softmax(const T* data, size_t size) {
@@ -44,7 +46,8 @@ int main(int argc, char **argv) {
     }
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
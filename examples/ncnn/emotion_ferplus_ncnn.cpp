@@ -7,6 +7,8 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+
 // A simple softmax implementation
 template <typename T>
 std::vector<T> softmax(const T* data, size_t size) {
@@ -31,7 +33,8 @@ int main(int argc, char **argv) {
     std::string model_param = argv[1];
     std::string model_bin = argv[2];
     std::string image_path = argv[3];
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 64, 64);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
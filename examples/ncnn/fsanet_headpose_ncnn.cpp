@@ -5,6 +5,9 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 int main(int argc, char **argv) {
     if (argc < 6) {
         std::cerr << "Usage: " << argv[0] << " <var_param_path> <var_bin_path> <conv_param_path> <conv_bin_path> <image_path>" << std::endl;
@@ -17,35 +20,35 @@ int main(int argc, char **argv) {
     const std::string image_path = argv[5];
 
     // --- Load Image and Preprocess ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, 64, 64);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
 
     const int input_size = 64;
-    
-    // 1. Padding
+
+    // 30% zero padding, resize and normalize in one pass straight from the
+    // image: the padded canvas is never built, pixels outside the image read
+    // as zero. Both models take this same input.
     const float pad = 0.3f;
     const int h = image.rows;
     const int w = image.cols;
     const int nh = static_cast<int>(static_cast<float>(h) + pad * static_cast<float>(h));
     const int nw = static_cast<int>(static_cast<float>(w) + pad * static_cast<float>(w));
-    const int nx1 = std::max(0, static_cast<int>((nw - w) / 2));
-    const int ny1 = std::max(0, static_cast<int>((nh - h) / 2));
-
-    cv::Mat padded_image = cv::Mat(nh, nw, CV_8UC3, cv::Scalar(0, 0, 0));
-    image.copyTo(padded_image(cv::Rect(nx1, ny1, w, h)));
-
-    // 2. Resize
-    cv::Mat resized;
-    cv::resize(padded_image, resized, cv::Size(input_size, input_size));
-    
-    // 3. Normalize to ncnn::Mat
-    ncnn::Mat in = ncnn::Mat::from_pixels(resized.data, ncnn::Mat::PIXEL_BGR, input_size, input_size);
     const float mean_vals[3] = {127.5f, 127.5f, 127.5f};
     const float norm_vals[3] = {1.0f/127.5f, 1.0f/127.5f, 1.0f/127.5f};
-    in.substract_mean_normalize(mean_vals, norm_vals);
+
+    ncnn::Mat in(input_size, input_size, 3);
+    mei::TensorView dst = mei::TensorView::dense(in.data, {1, 3, input_size, input_size},
+                                                 mei::DataType::Float32, mei::Layout::NCHW);
+    dst.strides[1] = static_cast<int64_t>(in.cstep);
+    dst.strides[0] = 3 * dst.strides[1];
+    const mei::ImageView view{image.data, w, h, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::InputTransform transform;
+    mei::crop_normalize(view, -(nw - w) / 2, -(nh - h) / 2, nw, nh, mei::PixelFormat::BGR, mean_vals, norm_vals,
+                        dst, transform);
 
     // --- Var Model Inference ---
     ncnn::Net var_net;
@@ -8,6 +8,8 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+
 // Softmax function
 template <typename T>
 static void softmax(T& input) {
@@ -33,7 +35,8 @@ int main(int argc, char **argv) {
     std::string image_path = argv[3];
     
     // 2. Load and Preprocess Image
-    cv::Mat img = cv::imread(image_path, cv::IMREAD_GRAYSCALE);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 28, 28, cv::IMREAD_GRAYSCALE);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
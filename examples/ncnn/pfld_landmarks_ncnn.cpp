@@ -4,6 +4,8 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+
 int main(int argc, char **argv) {
     if (argc < 4) {
         std::cerr << "Usage: " << argv[0] << " <param_path> <bin_path> <image_path>" << std::endl;
@@ -12,7 +14,8 @@ int main(int argc, char **argv) {
     std::string model_param = argv[1];
     std::string model_bin = argv[2];
     std::string image_path = argv[3];
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 112, 112);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
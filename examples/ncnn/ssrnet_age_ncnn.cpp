@@ -4,6 +4,9 @@
 #include <opencv2/opencv.hpp>
 #include <net.h>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 int main(int argc, char **argv) {
     if (argc < 4) {
         std::cerr << "Usage: " << argv[0] << " <param_path> <bin_path> <image_path>" << std::endl;
@@ -12,7 +15,8 @@ int main(int argc, char **argv) {
     std::string model_param = argv[1];
     std::string model_bin = argv[2];
     std::string image_path = argv[3];
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 64, 64);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
@@ -25,13 +29,17 @@ int main(int argc, char **argv) {
     }
     // 输入尺寸
     const int input_size = 64;
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(input_size, input_size));
-    ncnn::Mat in = ncnn::Mat::from_pixels(resized.data, ncnn::Mat::PIXEL_BGR2RGB, input_size, input_size);
     // Align with ONNX version's normalization (ImageNet mean/std)
     const float mean_vals[3] = {0.485f * 255.0f, 0.456f * 255.0f, 0.406f * 255.0f};
     const float norm_vals[3] = {1.0f / (0.229f * 255.0f), 1.0f / (0.224f * 255.0f), 1.0f / (0.229f * 255.0f)};
-    in.substract_mean_normalize(mean_vals, norm_vals);
+    // 缩放、BGR -> RGB、归一化一次完成，直接写入 ncnn::Mat（各通道按 cstep 对齐）
+    ncnn::Mat in(input_size, input_size, 3);
+    mei::TensorView dst = mei::TensorView::dense(in.data, {1, 3, input_size, input_size},
+                                                 mei::DataType::Float32, mei::Layout::NCHW);
+    dst.strides[1] = static_cast<int64_t>(in.cstep);
+    dst.strides[0] = 3 * dst.strides[1];
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, mei::PixelFormat::RGB, mean_vals, norm_vals, dst);
     ncnn::Extractor ex = net.create_extractor();
     ex.input("input", in);
     ncnn::Mat out;
@@ -5,45 +5,7 @@
 #include <net.h>
 #include <algorithm>
 
-struct FaceBox {
-    float x1, y1, x2, y2, score;
-};
-
-// NMS (Non-Maximum Suppression)
-static void nms(std::vector<FaceBox>& boxes, std::vector<FaceBox>& output, float iou_threshold) {
-    std::sort(boxes.begin(), boxes.end(), [](const FaceBox& a, const FaceBox& b) {
-        return a.score > b.score;
-    });
-
-    std::vector<bool> is_suppressed(boxes.size(), false);
-
-    for (size_t i = 0; i < boxes.size(); ++i) {
-        if (is_suppressed[i]) {
-            continue;
-        }
-        output.push_back(boxes[i]);
-        for (size_t j = i + 1; j < boxes.size(); ++j) {
-            if (is_suppressed[j]) {
-                continue;
-            }
-
-            float inter_x1 = std::max(boxes[i].x1, boxes[j].x1);
-            float inter_y1 = std::max(boxes[i].y1, boxes[j].y1);
-            float inter_x2 = std::min(boxes[i].x2, boxes[j].x2);
-            float inter_y2 = std::min(boxes[i].y2, boxes[j].y2);
-
-            float inter_area = std::max(0.0f, inter_x2 - inter_x1) * std::max(0.0f, inter_y2 - inter_y1);
-            float area1 = (boxes[i].x2 - boxes[i].x1) * (boxes[i].y2 - boxes[i].y1);
-            float area2 = (boxes[j].x2 - boxes[j].x1) * (boxes[j].y2 - boxes[j].y1);
-            float union_area = area1 + area2 - inter_area;
-
-            if (union_area > 0 && inter_area / union_area > iou_threshold) {
-                is_suppressed[j] = true;
-            }
-        }
-    }
-}
-
+#include "mei/detection_postprocess.h"
 
 int main(int argc, char **argv) {
     if (argc < 4) {
@@ -93,24 +55,17 @@ int main(int argc, char **argv) {
     // 后处理
     float score_threshold = 0.5f;
     float iou_threshold = 0.3f;
-    std::vector<FaceBox> bbox_collection;
-    // The number of proposals is in scores.h (height of the tensor)
-    for (int i = 0; i < scores.h; ++i) {
-        // scores tensor is [N, 2], boxes tensor is [N, 4]
-        // We only care about the confidence of the face class (index 1)
-        if (scores.row(i)[1] > score_threshold) {
-            FaceBox box;
-            box.x1 = boxes.row(i)[0] * img_w;
-            box.y1 = boxes.row(i)[1] * img_h;
-            box.x2 = boxes.row(i)[2] * img_w;
-            box.y2 = boxes.row(i)[3] * img_h;
-            box.score = scores.row(i)[1];
-            bbox_collection.push_back(box);
-        }
-    }
-
-    std::vector<FaceBox> detected_boxes;
-    nms(bbox_collection, detected_boxes, iou_threshold);
+    // scores 为 [N, 2]（背景、人脸），boxes 为 [N, 4]：先用 SIMD 对人脸分数做阈值筛选，
+    // 只读取并还原通过的框
+    mei::InputTransform stretch;
+    stretch.scale_x = target_w / img_w;
+    stretch.scale_y = target_h / img_h;
+    mei::DetectionBuffer bbox_collection;
+    mei::decode_ultraface(static_cast<const float*>(scores.data), static_cast<const float*>(boxes.data), scores.h,
+                          mei::UltraFaceBoxes::Corners, score_threshold, target_w, target_h, stretch, bbox_collection);
+
+    std::vector<mei::Detection> detected_boxes;
+    mei::nms(bbox_collection, iou_threshold, true, detected_boxes);
     
     if (detected_boxes.size() > 0) {
         printf("DEBUG NCNN: Detected %zu faces. Top detection score: %.4f\n", detected_boxes.size(), detected_boxes[0].score);
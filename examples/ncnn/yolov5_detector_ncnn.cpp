@@ -5,47 +5,8 @@
 #include <net.h>
 #include <algorithm>
 
-struct Object {
-    cv::Rect_<float> rect;
-    int label;
-    float prob;
-};
-
-// NMS implementation
-static void nms_sorted_bboxes(std::vector<Object>& objects, std::vector<int>& picked, float nms_threshold, bool agnostic = false)
-{
-    picked.clear();
-    const size_t n = objects.size();
-    std::vector<float> areas(n);
-    for (size_t i = 0; i < n; i++) {
-        areas[i] = objects[i].rect.area();
-    }
-
-    for (size_t i = 0; i < n; i++) {
-        const Object& a = objects[i];
-        int keep = 1;
-        for (size_t j = 0; j < picked.size(); j++) {
-            const Object& b = objects[picked[j]];
-            if (!agnostic && a.label != b.label) {
-                continue;
-            }
-            // intersection over union
-            cv::Rect_<float> inter = a.rect & b.rect;
-            float inter_area = inter.area();
-            float union_area = areas[i] + areas[picked[j]] - inter_area;
-            float iou = inter_area / union_area;
-            if (iou > nms_threshold)
-            {
-                keep = 0;
-                break;
-            }
-        }
-
-        if (keep) {
-            picked.push_back(i);
-        }
-    }
-}
+#include "mei/detection_postprocess.h"
+#include "mei/image_preprocess.h"
 
 int main(int argc, char **argv) {
     if (argc < 4) {
@@ -74,24 +35,16 @@ int main(int argc, char **argv) {
     const float mean_vals[3] = {0.f, 0.f, 0.f};
     const float norm_vals[3] = {1.0f/255, 1.0f/255, 1.0f/255};
 
-    // letterbox resize
-    int w = img.cols;
-    int h = img.rows;
-    float scale = std::min(target_size / (w*1.f), target_size / (h*1.f));
-    int new_w = w * scale;
-    int new_h = h * scale;
-    
-    int dw = (target_size - new_w) / 2;
-    int dh = (target_size - new_h) / 2;
-
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(new_w, new_h));
-    cv::Mat input = cv::Mat(target_size, target_size, CV_8UC3, cv::Scalar(114, 114, 114));
-    resized.copyTo(input(cv::Rect(dw, dh, new_w, new_h)));
-
-    // 转 ncnn::Mat
-    ncnn::Mat in = ncnn::Mat::from_pixels(input.data, ncnn::Mat::PIXEL_BGR2RGB, target_size, target_size);
-    in.substract_mean_normalize(mean_vals, norm_vals);
+    // letterbox：缩放到 114 填充的画布、BGR -> RGB、归一化一次完成，直接写入 ncnn::Mat
+    // （各通道按 cstep 对齐）
+    ncnn::Mat in(target_size, target_size, 3);
+    mei::TensorView dst = mei::TensorView::dense(in.data, {1, 3, target_size, target_size},
+                                                 mei::DataType::Float32, mei::Layout::NCHW);
+    dst.strides[1] = static_cast<int64_t>(in.cstep);
+    dst.strides[0] = 3 * dst.strides[1];
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::BGR};
+    mei::InputTransform letterbox;
+    mei::letterbox_normalize(view, mei::PixelFormat::RGB, mean_vals, norm_vals, 114.f, dst, letterbox);
 
     // 推理
     ncnn::Extractor ex = net.create_extractor();
@@ -99,89 +52,39 @@ int main(int argc, char **argv) {
     ncnn::Mat out;
     ex.extract("pred", out);
 
-    // 后处理
-    std::vector<Object> proposals;
+    // 后处理：先用 SIMD 扫描 objectness 列得到候选行，只对候选行求类别 argmax 和框坐标
     const float conf_threshold = 0.25f;
     const float nms_threshold = 0.45f;
-    const int num_grid = out.h;
-    const int num_class = out.w - 5;
-
-    for (int i = 0; i < num_grid; i++)
+    const int max_detections = 300;
+    mei::DetectionBuffer candidates;
+    mei::decode_yolov5(static_cast<const float*>(out.data), out.h, out.w - 5, conf_threshold, letterbox, candidates);
+
+    // 裁剪到图像范围内
+    const float max_x = static_cast<float>(img.cols - 1);
+    const float max_y = static_cast<float>(img.rows - 1);
+    for (size_t i = 0; i < candidates.size(); i++)
     {
-        const float* values = out.row(i);
-        float box_confidence = values[4];
-        if (box_confidence > conf_threshold)
-        {
-            // find max class
-            int class_index = 0;
-            float class_confidence = 0.f;
-            for (int j = 0; j < num_class; j++)
-            {
-                if (values[5 + j] > class_confidence)
-                {
-                    class_confidence = values[5 + j];
-                    class_index = j;
-                }
-            }
-
-            float final_confidence = box_confidence * class_confidence;
-            if (final_confidence > conf_threshold)
-            {
-                float cx = values[0];
-                float cy = values[1];
-                float box_w = values[2];
-                float box_h = values[3];
-                // 坐标还原
-                float x0 = (cx - box_w * 0.5f);
-                float y0 = (cy - box_h * 0.5f);
-                float x1 = (cx + box_w * 0.5f);
-                float y1 = (cy + box_h * 0.5f);
-                // 反 letterbox
-                x0 = (x0 - dw) / scale;
-                y0 = (y0 - dh) / scale;
-                x1 = (x1 - dw) / scale;
-                y1 = (y1 - dh) / scale;
-
-                x0 = std::max(std::min(x0, (float)(w - 1)), 0.f);
-                y0 = std::max(std::min(y0, (float)(h - 1)), 0.f);
-                x1 = std::max(std::min(x1, (float)(w - 1)), 0.f);
-                y1 = std::max(std::min(y1, (float)(h - 1)), 0.f);
-
-                Object obj;
-                obj.rect = cv::Rect_<float>(x0, y0, x1 - x0, y1 - y0);
-                obj.label = class_index;
-                obj.prob = final_confidence;
-                proposals.push_back(obj);
-            }
-        }
+        candidates.x1[i] = std::max(std::min(candidates.x1[i], max_x), 0.f);
+        candidates.y1[i] = std::max(std::min(candidates.y1[i], max_y), 0.f);
+        candidates.x2[i] = std::max(std::min(candidates.x2[i], max_x), 0.f);
+        candidates.y2[i] = std::max(std::min(candidates.y2[i], max_y), 0.f);
     }
 
-    // NMS
-    std::sort(proposals.begin(), proposals.end(), [](const Object& a, const Object& b) { return a.prob > b.prob; });
-    std::vector<int> picked;
-    nms_sorted_bboxes(proposals, picked, nms_threshold);
+    // NMS（按类别），最多保留 max_detections 个，按分数从高到低；只对需要的候选排序
+    std::vector<mei::Detection> detections;
+    mei::nms(candidates, nms_threshold, false, detections, max_detections);
     
-    if (picked.size() > 0) {
+    if (detections.size() > 0) {
         printf("DEBUG NCNN: Detected %zu objects. Top detection: Label %d, Score %.4f\n", 
-               picked.size(), proposals[picked[0]].label, proposals[picked[0]].prob);
+               detections.size(), detections[0].label, detections[0].score);
     }
 
-    if (picked.size() > 0 && proposals[picked[0]].prob > 0.5f) {
+    if (detections.size() > 0 && detections[0].score > 0.5f) {
         printf("true\n");
     } else {
         printf("false\n");
-        // Debugging: Print proposals before NMS if nothing was picked
-        if (picked.empty()) {
-            if (proposals.size() > 0) {
-                printf("DEBUG NCNN: No objects picked by NMS. Top 5 proposals before NMS:\n");
-                for (size_t i = 0; i < std::min((size_t)5, proposals.size()); ++i) {
-                    const auto& obj = proposals[i];
-                    printf("  - Label: %d, Prob: %.4f, Rect: [%.2f, %.2f, %.2f, %.2f]\n",
-                        obj.label, obj.prob, obj.rect.x, obj.rect.y, obj.rect.width, obj.rect.height);
-                }
-            } else {
-                printf("DEBUG NCNN: No proposals generated at all.\n");
-            }
+        if (detections.empty()) {
+            printf("DEBUG NCNN: No proposals generated at all.\n");
         }
     }
     return 0;
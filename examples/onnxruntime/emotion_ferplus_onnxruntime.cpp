@@ -8,6 +8,9 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 // --- Helper Functions ---
 
 // A simple softmax implementation
@@ -59,21 +62,23 @@ int main(int argc, char **argv) {
     std::cout << "--------------------" << std::endl;
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
 
-    cv::Mat resized_image;
-    cv::resize(image, resized_image, cv::Size(input_width, input_height));
-    cv::cvtColor(resized_image, resized_image, cv::COLOR_BGR2GRAY);
-
+    // Resize, BGR -> gray and float conversion in one pass: the two bilinear
+    // taps of each output pixel are reduced to luma first, so no resized
+    // color image or float copy is made. Raw 0-255 pixel values.
     std::vector<float> input_tensor_values(1 * 1 * input_height * input_width);
-    resized_image.convertTo(resized_image, CV_32F);
-    
-    // Flatten the image data
-    memcpy(input_tensor_values.data(), resized_image.data, input_tensor_values.size() * sizeof(float));
+    const float mean[1] = {0.f};
+    const float norm[1] = {1.f};
+    const mei::ImageView view{image.data, image.cols, image.rows, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, mei::PixelFormat::Gray, mean, norm,
+                          mei::TensorView::dense(input_tensor_values.data(), {1, 1, input_height, input_width},
+                                                 mei::DataType::Float32, mei::Layout::NCHW));
 
     // --- Create Tensor ---
     std::vector<int64_t> input_node_dims = {1, 1, input_height, input_width};
@@ -8,6 +8,8 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include "mei/image_io_opencv.h"
+
 // Helper function to run inference on a single model
 void run_fsanet_model(
     Ort::Session& session,
@@ -96,7 +98,8 @@ int main(int argc, char **argv) {
     Ort::AllocatorWithDefaultOptions allocator;
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the 64x64 input.
+    cv::Mat image = mei::imread_for_input(image_path, 64, 64);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
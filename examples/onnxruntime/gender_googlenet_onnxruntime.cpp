@@ -8,6 +8,9 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 // --- Helper Functions ---
 
 // A simple softmax implementation
@@ -61,29 +64,20 @@ int main(int argc, char **argv) {
     std::cout << "--------------------" << std::endl;
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
 
-    cv::Mat resized_image;
-    cv::resize(image, resized_image, cv::Size(input_width, input_height));
-    cv::cvtColor(resized_image, resized_image, cv::COLOR_BGR2RGB);
-
+    // Resize, BGR -> RGB, normalize to [-1, 1] and HWC -> CHW in one pass.
     std::vector<float> input_tensor_values(1 * 3 * input_height * input_width);
-    resized_image.convertTo(resized_image, CV_32F);
-    
-    // Normalize to [-1, 1]
-    // HWC to CHW and normalize
-    for (int c = 0; c < 3; ++c) {
-        for (int h = 0; h < input_height; ++h) {
-            for (int w = 0; w < input_width; ++w) {
-                input_tensor_values[c * input_height * input_width + h * input_width + w] =
-                    (resized_image.at<cv::Vec3f>(h, w)[c] - 127.5f) / 128.0f;
-            }
-        }
-    }
+    const float mean[3] = {127.5f, 127.5f, 127.5f};
+    const float norm[3] = {1.0f / 128.0f, 1.0f / 128.0f, 1.0f / 128.0f};
+    const mei::ImageView view{image.data, image.cols, image.rows, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, input_width, input_height, mei::PixelFormat::RGB, mean, norm, mei::Layout::NCHW,
+                          input_tensor_values.data());
 
     // --- Create Tensor ---
     std::vector<int64_t> input_node_dims = {1, 3, input_height, input_width};
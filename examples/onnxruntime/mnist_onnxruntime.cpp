@@ -8,6 +8,8 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include "mei/image_io_opencv.h"
+
 // Softmax function
 template <typename T>
 static void softmax(T& input) {
@@ -42,7 +44,8 @@ int main(int argc, char **argv) {
     Ort::AllocatorWithDefaultOptions allocator;
 
     // 3. Preprocessing
-    cv::Mat image = cv::imread(image_path, cv::IMREAD_GRAYSCALE);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height, cv::IMREAD_GRAYSCALE);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
@@ -8,6 +8,9 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 // --- Main Inference Logic ---
 int main(int argc, char **argv) {
     if (argc < 3) {
@@ -41,31 +44,22 @@ int main(int argc, char **argv) {
     std::cout << "--------------------" << std::endl;
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_width, input_height);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
 
-    cv::Mat resized_image;
-    cv::resize(image, resized_image, cv::Size(input_width, input_height));
-    resized_image.convertTo(resized_image, CV_32F, 1.0 / 255.0);
-    
-    // Normalize (mean=[0.485, 0.456, 0.406], std=[0.229, 0.224, 0.225])
-    float mean[] = {0.485f, 0.456f, 0.406f};
-    float scale[] = {1/0.229f, 1/0.224f, 1/0.225f};
-    
+    // Resize, scale to [0, 1], normalize (mean=[0.485, 0.456, 0.406],
+    // std=[0.229, 0.224, 0.225]) and HWC -> CHW in one pass. The model takes
+    // BGR, the /255 is folded into mean and norm.
+    const float mean[3] = {0.485f * 255.0f, 0.456f * 255.0f, 0.406f * 255.0f};
+    const float norm[3] = {1.0f / (0.229f * 255.0f), 1.0f / (0.224f * 255.0f), 1.0f / (0.225f * 255.0f)};
     std::vector<float> input_tensor_values(1 * 3 * input_height * input_width);
-    
-    // HWC to CHW and normalize
-    for (int c = 0; c < 3; ++c) {
-        for (int h = 0; h < input_height; ++h) {
-            for (int w = 0; w < input_width; ++w) {
-                input_tensor_values[c * input_height * input_width + h * input_width + w] =
-                    (resized_image.at<cv::Vec3f>(h, w)[c] - mean[c]) * scale[c];
-            }
-        }
-    }
+    const mei::ImageView view{image.data, image.cols, image.rows, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, input_width, input_height, mei::PixelFormat::BGR, mean, norm, mei::Layout::NCHW,
+                          input_tensor_values.data());
 
     // --- Create Tensor ---
     std::vector<int64_t> input_node_dims = {1, 3, input_height, input_width};
@@ -8,50 +8,8 @@
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
 
-// --- Data Structures ---
-struct Box {
-    float x1, y1, x2, y2;
-    float score;
-    int label;
-};
-
-// --- Helper Functions ---
-
-// NMS (Non-Maximum Suppression)
-void nms(std::vector<Box>& boxes, std::vector<Box>& output, float iou_threshold) {
-    std::sort(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
-        return a.score > b.score;
-    });
-
-    std::vector<bool> is_suppressed(boxes.size(), false);
-
-    for (size_t i = 0; i < boxes.size(); ++i) {
-        if (is_suppressed[i]) {
-            continue;
-        }
-        output.push_back(boxes[i]);
-        for (size_t j = i + 1; j < boxes.size(); ++j) {
-            if (is_suppressed[j]) {
-                continue;
-            }
-
-            float inter_x1 = std::max(boxes[i].x1, boxes[j].x1);
-            float inter_y1 = std::max(boxes[i].y1, boxes[j].y1);
-            float inter_x2 = std::min(boxes[i].x2, boxes[j].x2);
-            float inter_y2 = std::min(boxes[i].y2, boxes[j].y2);
-
-            float inter_area = std::max(0.0f, inter_x2 - inter_x1) * std::max(0.0f, inter_y2 - inter_y1);
-            float area1 = (boxes[i].x2 - boxes[i].x1) * (boxes[i].y2 - boxes[i].y1);
-            float area2 = (boxes[j].x2 - boxes[j].x1) * (boxes[j].y2 - boxes[j].y1);
-            float union_area = area1 + area2 - inter_area;
-
-            if (union_area > 0 && inter_area / union_area > iou_threshold) {
-                is_suppressed[j] = true;
-            }
-        }
-    }
-}
-
+#include "mei/detection_postprocess.h"
+#include "mei/image_preprocess.h"
 
 // --- Main Inference Logic ---
 int main(int argc, char **argv) {
@@ -97,24 +55,13 @@ int main(int argc, char **argv) {
     const float img_height = static_cast<float>(image.rows);
     const float img_width = static_cast<float>(image.cols);
 
-    cv::Mat resized_image;
-    cv::cvtColor(image, resized_image, cv::COLOR_BGR2RGB);
-    cv::resize(resized_image, resized_image, cv::Size(input_width, input_height));
-
+    // Resize, BGR -> RGB, normalize (mean 127, scale 1/128) and HWC -> CHW in one pass.
     std::vector<float> input_tensor_values(1 * 3 * input_height * input_width);
-    resized_image.convertTo(resized_image, CV_32F);
-
-    // Normalize and HWC to CHW
-    const float mean_val = 127.0f;
-    const float scale_val = 1.0f / 128.0f;
-    for (int c = 0; c < 3; ++c) {
-        for (int h = 0; h < input_height; ++h) {
-            for (int w = 0; w < input_width; ++w) {
-                input_tensor_values[c * input_height * input_width + h * input_width + w] =
-                    (resized_image.at<cv::Vec3f>(h, w)[c] - mean_val) * scale_val;
-            }
-        }
-    }
+    const float mean[3] = {127.0f, 127.0f, 127.0f};
+    const float norm[3] = {1.0f / 128.0f, 1.0f / 128.0f, 1.0f / 128.0f};
+    const mei::ImageView view{image.data, image.cols, image.rows, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, input_width, input_height, mei::PixelFormat::RGB, mean, norm, mei::Layout::NCHW,
+                          input_tensor_values.data());
 
     // --- Create Tensor ---
     std::vector<int64_t> input_node_dims = {1, 3, input_height, input_width};
@@ -139,24 +86,19 @@ int main(int argc, char **argv) {
     auto scores_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
     const int num_anchors = scores_shape[1];
 
-    std::vector<Box> bbox_collection;
-    for (int i = 0; i < num_anchors; ++i) {
-        float confidence = scores_data[i * 2 + 1];
-        if (confidence < score_threshold) continue;
-
-        Box box;
-        box.x1 = boxes_data[i * 4 + 0] * img_width;
-        box.y1 = boxes_data[i * 4 + 1] * img_height;
-        box.x2 = boxes_data[i * 4 + 2] * img_width;
-        box.y2 = boxes_data[i * 4 + 3] * img_height;
-        box.score = confidence;
-        box.label = 1; // "face"
-        bbox_collection.push_back(box);
-    }
-    
+    // Face scores are thresholded first (SIMD); only the survivors' boxes are
+    // read and scaled back to the image. A model exported without the box
+    // decode would pass mei::UltraFaceBoxes::Regression instead.
+    mei::InputTransform stretch;
+    stretch.scale_x = input_width / img_width;
+    stretch.scale_y = input_height / img_height;
+    mei::DetectionBuffer bbox_collection;
+    mei::decode_ultraface(scores_data, boxes_data, num_anchors, mei::UltraFaceBoxes::Corners, score_threshold,
+                          input_width, input_height, stretch, bbox_collection);
+
     // NMS
-    std::vector<Box> detected_boxes;
-    nms(bbox_collection, detected_boxes, iou_threshold);
+    std::vector<mei::Detection> detected_boxes;
+    mei::nms(bbox_collection, iou_threshold, true, detected_boxes);
 
     if (detected_boxes.size() > 0) {
         printf("DEBUG ONNX: Detected %zu faces. Top detection score: %.4f\n", detected_boxes.size(), detected_boxes[0].score);
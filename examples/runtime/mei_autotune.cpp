@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mei/autotune.h"
+
+// Benchmarks every given model file with every enabled engine and its knobs on
+// this machine, and records the fastest one per model in a profile. Point
+// MEI_TUNE_PROFILE at the profile and mei::Model::load() picks it up.
+// Candidates whose outputs drift from the default config's (past --max-error)
+// are dropped, and lower precision files (_float16, _int8, ...) are only tried
+// with --allow-lower-precision.
+//
+//   mei_autotune host.profile assets/ultraface_detector.onnx assets/ultraface_detector.mnn
+//                assets/ultraface_detector.param assets/ultraface_detector_float32.tflite
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <profile> <model_path>... [--threads max] [--runs n]"
+                  << " [--max-error e] [--allow-lower-precision]" << std::endl;
+        return -1;
+    }
+    const std::string profile_path = argv[1];
+    mei::TuneOptions options;
+    // Formats of the same model are grouped and compete against each other.
+    std::map<std::string, std::vector<std::string>> models;
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) options.max_threads = atoi(argv[++i]);
+        else if (arg == "--runs" && i + 1 < argc) options.runs = atoi(argv[++i]);
+        else if (arg == "--max-error" && i + 1 < argc) options.max_output_error = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--allow-lower-precision") options.allow_lower_precision = true;
+        else models[mei::tune_key(arg)].push_back(arg);
+    }
+
+    // Existing entries of other models are kept.
+    mei::TuneProfile profile;
+    profile.load(profile_path);
+    for (const auto& kv : models) {
+        printf("== %s\n", kv.first.c_str());
+        mei::TuneEntry best;
+        if (!mei::autotune(kv.second, options, best)) {
+            std::cerr << "No engine could run " << kv.first << std::endl;
+            continue;
+        }
+        printf("-> %s: %s, %d threads, %.3f ms (%s)\n", best.model.c_str(), best.engine.c_str(),
+               best.config.num_threads, best.avg_ms, best.model_path.c_str());
+        profile.set(best);
+    }
+    if (!profile.save(profile_path)) {
+        std::cerr << "Failed to write profile: " << profile_path << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mei/detection_postprocess.h"
+
+// Times mei::nms() with each NmsMethod against the plain greedy pairwise loop
+// the examples used to carry, on synthetic crowd scenes: yolov5 style
+// candidates clustered around many small objects, as a low score threshold
+// leaves them. Every method must keep exactly the boxes the loop keeps, and
+// with --top k the first k of them.
+//
+//   mei_nms_bench --runs 20 --iou 0.45 --classes 1 --top 100
+
+// The examples' nms_sorted_bboxes(): each candidate, by descending score,
+// against every box kept so far.
+static void reference_nms(const mei::DetectionBuffer& boxes, float iou_threshold, bool agnostic,
+                          std::vector<mei::Detection>& kept) {
+    std::vector<mei::Detection> sorted;
+    boxes.append_to(sorted);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const mei::Detection& a, const mei::Detection& b) { return a.score > b.score; });
+    kept.clear();
+    for (const mei::Detection& a : sorted) {
+        const float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+        bool keep = true;
+        for (const mei::Detection& b : kept) {
+            if (!agnostic && a.label != b.label) {
+                continue;
+            }
+            const float iw = std::max(0.f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+            const float ih = std::max(0.f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+            const float inter = iw * ih;
+            const float uni = area_a + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
+            if (uni > 0.f && inter / uni > iou_threshold) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            kept.push_back(a);
+        }
+    }
+}
+
+// `count` candidates in a 1920x1080 frame: objects of 16 - 96 px, each
+// reported by about 8 jittered anchors, as yolov5 does for a crowd.
+static void crowd_scene(int count, int num_classes, std::mt19937& rng, mei::DetectionBuffer& boxes) {
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::normal_distribution<float> jitter(0.f, 0.08f);
+    boxes.resize(0);
+    while (static_cast<int>(boxes.size()) < count) {
+        const float w = 16.f + 80.f * uniform(rng), h = w * (1.f + 1.5f * uniform(rng));
+        const float cx = 1920.f * uniform(rng), cy = 1080.f * uniform(rng);
+        const int label = static_cast<int>(uniform(rng) * num_classes);
+        for (int k = 0; k < 8 && static_cast<int>(boxes.size()) < count; k++) {
+            const float bx = cx + w * jitter(rng), by = cy + h * jitter(rng);
+            const float bw = w * (1.f + jitter(rng)), bh = h * (1.f + jitter(rng));
+            boxes.push_back(bx - bw / 2, by - bh / 2, bx + bw / 2, by + bh / 2, uniform(rng), label);
+        }
+    }
+}
+
+static bool same_boxes(const std::vector<mei::Detection>& a, const std::vector<mei::Detection>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].x1 != b[i].x1 || a[i].y1 != b[i].y1 || a[i].x2 != b[i].x2 || a[i].y2 != b[i].y2 ||
+            a[i].score != b[i].score || a[i].label != b[i].label) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int runs = 10;
+    float iou_threshold = 0.45f;
+    int num_classes = 1;
+    int top_k = 100;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) runs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--iou" && i + 1 < argc) iou_threshold = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--classes" && i + 1 < argc) num_classes = std::max(1, atoi(argv[++i]));
+        else if (arg == "--top" && i + 1 < argc) top_k = std::max(1, atoi(argv[++i]));
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--runs n] [--iou threshold] [--classes n] [--top k]"
+                      << std::endl;
+            return -1;
+        }
+    }
+
+    std::mt19937 rng(2024);
+    mei::DetectionBuffer boxes;
+    std::vector<mei::Detection> expected, kept;
+    bool all_same = true;
+    const std::string top = "top " + std::to_string(top_k);
+    printf("%8s %8s %12s %12s %12s %12s %12s  %s\n", "boxes", "kept", "reference", "pairwise", "grid", "auto",
+           top.c_str(), "same");
+    for (int count : {500, 1000, 2000, 5000, 10000, 20000, 50000}) {
+        crowd_scene(count, num_classes, rng, boxes);
+        for (int agnostic = 0; agnostic < 2; agnostic++) {
+            auto time_ms = [&](auto&& fn) {
+                fn();
+                const auto start = std::chrono::steady_clock::now();
+                for (int r = 0; r < runs; r++) fn();
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                       runs;
+            };
+            const double reference_ms = time_ms([&] { reference_nms(boxes, iou_threshold, agnostic, expected); });
+            bool same = true;
+            double ms[4];
+            const mei::NmsMethod methods[3] = {mei::NmsMethod::Pairwise, mei::NmsMethod::Grid, mei::NmsMethod::Auto};
+            for (int m = 0; m < 3; m++) {
+                ms[m] = time_ms([&] { mei::nms(boxes, iou_threshold, agnostic, kept, 0, methods[m]); });
+                same = same && same_boxes(expected, kept);
+            }
+            const size_t num_kept = expected.size();
+            ms[3] = time_ms([&] { mei::nms(boxes, iou_threshold, agnostic, kept, top_k); });
+            expected.resize(std::min(expected.size(), static_cast<size_t>(top_k)));
+            same = same && same_boxes(expected, kept);
+            all_same = all_same && same;
+            printf("%8d %8zu %9.3f ms %9.3f ms %9.3f ms %9.3f ms %9.3f ms  %s%s\n", count, num_kept,
+                   reference_ms, ms[0], ms[1], ms[2], ms[3], same ? "yes" : "NO", agnostic ? " (agnostic)" : "");
+        }
+    }
+    return all_same ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+#include "mei/image_io_opencv.h"
+#include "mei/model.h"
+
+// Runs any model of the spec table on one image. Input size, normalization,
+// color order and output blobs come from the spec picked by the model file
+// name, so the same binary covers every model and every enabled backend.
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <model_path> <image_path> [--spec name] [--threads n]" << std::endl;
+        return -1;
+    }
+    const std::string model_path = argv[1];
+    const std::string image_path = argv[2];
+    std::string spec_name;
+    mei::EngineConfig config;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        const std::string opt = argv[i];
+        if (opt == "--spec") spec_name = argv[i + 1];
+        else if (opt == "--threads") config.num_threads = atoi(argv[i + 1]);
+    }
+
+    mei::Model model;
+    bool ok;
+    if (spec_name.empty()) {
+        ok = model.load(model_path, config);
+    } else {
+        const mei::ModelSpec* spec = mei::find_model_spec(spec_name);
+        ok = spec && model.load(*spec, model_path, config);
+    }
+    if (!ok) {
+        std::cerr << "Failed to load model: " << model_path << std::endl;
+        return -1;
+    }
+
+    const bool gray = model.spec()->color == mei::PixelFormat::Gray;
+    // Small input models decode JPEGs at a reduced scale, Model does the final resize.
+    cv::Mat image = mei::imread_for_spec(image_path, *model.spec());
+    if (image.empty()) {
+        std::cerr << "Failed to load image: " << image_path << std::endl;
+        return -1;
+    }
+    mei::ImageView view;
+    view.data = image.data;
+    view.width = image.cols;
+    view.height = image.rows;
+    view.stride = static_cast<int>(image.step);
+    view.format = gray ? mei::PixelFormat::Gray : mei::PixelFormat::BGR;
+
+    mei::Prediction result;
+    if (!model.predict(view, result)) {
+        std::cerr << "Inference failed" << std::endl;
+        return -1;
+    }
+
+    printf("spec: %s, engine: %s\n", model.spec()->name, model.engine()->name());
+    for (const auto& d : result.detections) {
+        printf("  - label %d, score %.4f, box [%.1f, %.1f, %.1f, %.1f]\n", d.label, d.score, d.x1, d.y1, d.x2, d.y2);
+    }
+    for (size_t i = 0; i < result.values.size(); i++) {
+        printf("  - value %zu: %.4f\n", i, result.values[i]);
+    }
+    return 0;
+}
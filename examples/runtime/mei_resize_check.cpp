@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "mei/image_preprocess.h"
+
+// Checks mei::resize_normalize() against cv::resize(INTER_LINEAR), which the
+// examples used before, over a range of scale factors. With mean 0 and norm 1
+// the output is the resampled 8-bit image itself; every pixel must be within
+// 1 of OpenCV's (see the note on kCoefBits in src/preprocess.cpp). Sources are
+// a noise image, the worst case for rounding, and a smooth gradient, taken as
+// a cropped view so the row stride is not width * 3.
+//
+//   mei_resize_check --width 1280 --height 720
+
+static cv::Mat noise_image(int width, int height, std::mt19937& rng) {
+    cv::Mat canvas(height + 2, width + 8, CV_8UC3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int y = 0; y < canvas.rows; y++) {
+        uint8_t* row = canvas.ptr<uint8_t>(y);
+        for (int x = 0; x < canvas.cols * 3; x++) row[x] = static_cast<uint8_t>(byte(rng));
+    }
+    return canvas(cv::Rect(3, 1, width, height));
+}
+
+static cv::Mat gradient_image(int width, int height) {
+    cv::Mat canvas(height + 2, width + 8, CV_8UC3);
+    for (int y = 0; y < canvas.rows; y++) {
+        uint8_t* row = canvas.ptr<uint8_t>(y);
+        for (int x = 0; x < canvas.cols; x++) {
+            row[3 * x] = static_cast<uint8_t>(255 * x / canvas.cols);
+            row[3 * x + 1] = static_cast<uint8_t>(255 * y / canvas.rows);
+            row[3 * x + 2] = static_cast<uint8_t>((x + y) & 255);
+        }
+    }
+    return canvas(cv::Rect(3, 1, width, height));
+}
+
+// Largest |mei - cv::resize| over all pixels and channels.
+static int max_difference(const cv::Mat& src, int dst_width, int dst_height) {
+    static const float kMean[3] = {0.f, 0.f, 0.f};
+    static const float kNorm[3] = {1.f, 1.f, 1.f};
+    const mei::ImageView view{src.data, src.cols, src.rows, static_cast<int>(src.step), mei::PixelFormat::BGR};
+    std::vector<float> out(static_cast<size_t>(dst_width) * dst_height * 3);
+    mei::resize_normalize(view, dst_width, dst_height, mei::PixelFormat::BGR, kMean, kNorm, mei::Layout::NHWC,
+                          out.data());
+
+    cv::Mat expected;
+    cv::resize(src, expected, cv::Size(dst_width, dst_height), 0, 0, cv::INTER_LINEAR);
+    int worst = 0;
+    for (int y = 0; y < dst_height; y++) {
+        const uint8_t* row = expected.ptr<uint8_t>(y);
+        const float* got = out.data() + static_cast<size_t>(y) * dst_width * 3;
+        for (int x = 0; x < dst_width * 3; x++) {
+            worst = std::max(worst, static_cast<int>(std::lround(std::fabs(got[x] - row[x]))));
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char **argv) {
+    int width = 1280;
+    int height = 720;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--width" && i + 1 < argc) width = std::max(2, atoi(argv[++i]));
+        else if (arg == "--height" && i + 1 < argc) height = std::max(2, atoi(argv[++i]));
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--width w] [--height h]" << std::endl;
+            return -1;
+        }
+    }
+
+    std::mt19937 rng(2024);
+    const cv::Mat sources[2] = {noise_image(width, height, rng), gradient_image(width, height)};
+    const char* source_names[2] = {"noise", "gradient"};
+    // Integer and fractional downscales (exact 2x takes OpenCV's area path),
+    // identity, and upscales.
+    const double scales[] = {1.0 / 8, 1.0 / 4, 1.0 / 3, 1.0 / 2, 0.7, 224.0 / 1280, 1.0, 1.5, 2.0, 3.0};
+
+    bool all_within = true;
+    printf("%10s %8s %12s %8s  %s\n", "source", "scale", "output", "max diff", "ok");
+    for (int s = 0; s < 2; s++) {
+        for (double scale : scales) {
+            const int dst_width = std::max(1, static_cast<int>(std::lround(width * scale)));
+            const int dst_height = std::max(1, static_cast<int>(std::lround(height * scale)));
+            const int diff = max_difference(sources[s], dst_width, dst_height);
+            const bool ok = diff <= 1;
+            all_within = all_within && ok;
+            const std::string size = std::to_string(dst_width) + "x" + std::to_string(dst_height);
+            printf("%10s %8.3f %12s %8d  %s\n", source_names[s], scale, size.c_str(), diff, ok ? "yes" : "NO");
+        }
+    }
+    return all_within ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mei/engine.h"
+#include "mei/engine_registry.h"
+
+// Generic runner on top of the engine registry: the backend is picked from the
+// model extension (or --engine), so one binary covers every backend that was
+// enabled at build time.
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <model_path> [--engine name] [--threads n] [--runs n]" << std::endl;
+        std::cerr << "Enabled engines:";
+        for (const auto& name : mei::EngineRegistry::instance().names()) {
+            std::cerr << " " << name;
+        }
+        std::cerr << std::endl;
+        return -1;
+    }
+    const std::string model_path = argv[1];
+    std::string engine_name;
+    mei::EngineConfig config;
+    int runs = 10;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string opt = argv[i];
+        if (opt == "--engine") engine_name = argv[i + 1];
+        else if (opt == "--threads") config.num_threads = atoi(argv[i + 1]);
+        else if (opt == "--runs") runs = atoi(argv[i + 1]);
+    }
+
+    std::unique_ptr<mei::Engine> engine = engine_name.empty()
+        ? mei::create_engine_for_model(model_path)
+        : mei::create_engine(engine_name);
+    if (!engine) {
+        return -1;
+    }
+    if (!engine->load(mei::model_files_for(model_path), config)) {
+        std::cerr << "Failed to load model: " << model_path << std::endl;
+        return -1;
+    }
+
+    // Zero filled inputs of the declared shapes and types.
+    std::vector<std::vector<uint8_t>> inputs(engine->input_shapes().size());
+    std::vector<mei::TensorView> views;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (int64_t d : engine->input_shapes()[i]) {
+            if (d <= 0) {
+                std::cerr << "Input " << engine->input_names()[i] << " has a dynamic shape" << std::endl;
+                return -1;
+            }
+        }
+        mei::TensorView view = mei::TensorView::dense(nullptr, engine->input_shapes()[i], engine->input_dtype(i),
+                                                      engine->input_layouts()[i]);
+        view.quant = engine->input_quant(i);
+        inputs[i].assign(view.storage_bytes(), 0);
+        view.data = inputs[i].data();
+        views.push_back(view);
+    }
+
+    std::vector<mei::TensorView> outputs;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; r++) {
+        if (!engine->infer(views, outputs)) {
+            return -1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double avg_ms = std::chrono::duration<double, std::milli>(end - start).count() / std::max(runs, 1);
+
+    printf("engine: %s, runs: %d, avg: %.3f ms\n", engine->name(), runs, avg_ms);
+    for (size_t i = 0; i < outputs.size(); i++) {
+        printf("  - Output %zu: %s [", i, engine->output_names()[i].c_str());
+        for (int d = 0; d < outputs[i].ndim; d++) {
+            printf("%s%lld", d ? ", " : "", (long long)outputs[i].shape[d]);
+        }
+        printf("]\n");
+    }
+    return 0;
+}
@@ -8,6 +8,8 @@
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 
+#include "mei/image_io_opencv.h"
+
 // Helper function to run inference on a single TFLite model
 void run_fsanet_model(
     tflite::Interpreter* interpreter,
@@ -78,7 +80,8 @@ int main(int argc, char **argv) {
     conv_interpreter->AllocateTensors();
 
     // --- Image Loading ---
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, 64, 64);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
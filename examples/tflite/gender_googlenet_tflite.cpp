@@ -10,6 +10,8 @@
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 
+#include "mei/image_io_opencv.h"
+
 // Helper: Softmax
 template <typename T>
 std::vector<T> softmax(const T* data, size_t size) {
@@ -47,7 +49,8 @@ int main(int argc, char **argv) {
     interpreter->AllocateTensors();
 
     // --- Preprocessing ---
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, input_size, input_size);
     if (image.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
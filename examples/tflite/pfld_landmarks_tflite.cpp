@@ -6,6 +6,9 @@
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 
+#include "mei/image_io_opencv.h"
+#include "mei/image_preprocess.h"
+
 int main(int argc, char **argv) {
     if (argc < 3) {
         std::cerr << "Usage: " << argv[0] << " <model_path> <image_path>" << std::endl;
@@ -52,25 +55,21 @@ int main(int argc, char **argv) {
     std::cout << "--------------------" << std::endl;
 
     // --- Preprocessing ---
-    cv::Mat img = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat img = mei::imread_for_input(image_path, input_size, input_size);
     if (img.empty()) {
         std::cerr << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(input_size, input_size));
-    cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
 
     // --- Fill input tensor ---
-    float* input_ptr = interpreter->typed_input_tensor<float>(0);
-    for (int h = 0; h < input_size; ++h) {
-        for (int w = 0; w < input_size; ++w) {
-            for (int c = 0; c < 3; ++c) {
-                // Normalize to [-1, 1]
-                input_ptr[(h * input_size + w) * 3 + c] = (resized.at<cv::Vec3b>(h, w)[c] - 127.5f) / 128.0f;
-            }
-        }
-    }
+    // Resize, BGR -> RGB and normalization to [-1, 1] in one pass, written
+    // straight into the NHWC input tensor.
+    const float mean[3] = {127.5f, 127.5f, 127.5f};
+    const float norm[3] = {1 / 128.0f, 1 / 128.0f, 1 / 128.0f};
+    const mei::ImageView view{img.data, img.cols, img.rows, static_cast<int>(img.step), mei::PixelFormat::BGR};
+    mei::resize_normalize(view, input_size, input_size, mei::PixelFormat::RGB, mean, norm, mei::Layout::NHWC,
+                          interpreter->typed_input_tensor<float>(0));
 
     // --- Inference ---
     interpreter->Invoke();
@@ -7,44 +7,7 @@
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 
-struct FaceBox {
-    float x1, y1, x2, y2, score;
-};
-
-// NMS (Non-Maximum Suppression)
-static void nms(std::vector<FaceBox>& boxes, std::vector<FaceBox>& output, float iou_threshold) {
-    std::sort(boxes.begin(), boxes.end(), [](const FaceBox& a, const FaceBox& b) {
-        return a.score > b.score;
-    });
-
-    std::vector<bool> is_suppressed(boxes.size(), false);
-
-    for (size_t i = 0; i < boxes.size(); ++i) {
-        if (is_suppressed[i]) {
-            continue;
-        }
-        output.push_back(boxes[i]);
-        for (size_t j = i + 1; j < boxes.size(); ++j) {
-            if (is_suppressed[j]) {
-                continue;
-            }
-
-            float inter_x1 = std::max(boxes[i].x1, boxes[j].x1);
-            float inter_y1 = std::max(boxes[i].y1, boxes[j].y1);
-            float inter_x2 = std::min(boxes[i].x2, boxes[j].x2);
-            float inter_y2 = std::min(boxes[i].y2, boxes[j].y2);
-
-            float inter_area = std::max(0.0f, inter_x2 - inter_x1) * std::max(0.0f, inter_y2 - inter_y1);
-            float area1 = (boxes[i].x2 - boxes[i].x1) * (boxes[i].y2 - boxes[i].y1);
-            float area2 = (boxes[j].x2 - boxes[j].x1) * (boxes[j].y2 - boxes[j].y1);
-            float union_area = area1 + area2 - inter_area;
-
-            if (union_area > 0 && inter_area / union_area > iou_threshold) {
-                is_suppressed[j] = true;
-            }
-        }
-    }
-}
+#include "mei/detection_postprocess.h"
 
 int main(int argc, char **argv) {
     if (argc < 3) {
@@ -103,21 +66,17 @@ int main(int argc, char **argv) {
     float score_threshold = 0.5f;
     float iou_threshold = 0.3f;
     
-    std::vector<FaceBox> bbox_collection;
-    for (int i = 0; i < num_proposals; ++i) {
-        if (scores_ptr[i * 2 + 1] > score_threshold) { // index 1 is face score
-            FaceBox box;
-            box.x1 = boxes_ptr[i * 4 + 0] * img_w;
-            box.y1 = boxes_ptr[i * 4 + 1] * img_h;
-            box.x2 = boxes_ptr[i * 4 + 2] * img_w;
-            box.y2 = boxes_ptr[i * 4 + 3] * img_h;
-            box.score = scores_ptr[i * 2 + 1];
-            bbox_collection.push_back(box);
-        }
-    }
-
-    std::vector<FaceBox> detected_boxes;
-    nms(bbox_collection, detected_boxes, iou_threshold);
+    // Face scores are thresholded first (SIMD); only the survivors' boxes are
+    // read and scaled back to the image.
+    mei::InputTransform stretch;
+    stretch.scale_x = input_w / img_w;
+    stretch.scale_y = input_h / img_h;
+    mei::DetectionBuffer bbox_collection;
+    mei::decode_ultraface(scores_ptr, boxes_ptr, num_proposals, mei::UltraFaceBoxes::Corners, score_threshold,
+                          input_w, input_h, stretch, bbox_collection);
+
+    std::vector<mei::Detection> detected_boxes;
+    mei::nms(bbox_collection, iou_threshold, true, detected_boxes);
 
     if (detected_boxes.size() > 0) {
         printf("DEBUG TFLITE: Detected %zu faces. Top detection score: %.4f\n", detected_boxes.size(), detected_boxes[0].score);
@@ -6,6 +6,8 @@
 #include <tnn/core/mat.h>
 #include <tnn/utils/blob_converter.h>
 
+#include "mei/image_io_opencv.h"
+
 using namespace TNN_NS;
 
 int main(int argc, char** argv) {
@@ -35,7 +37,8 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    cv::Mat image = cv::imread(image_path);
+    // Decode at the smallest JPEG scale that still covers the input.
+    cv::Mat image = mei::imread_for_input(image_path, 64, 64);
     if (image.empty()) {
         std::cout << "Failed to load image: " << image_path << std::endl;
         return -1;
@@ -1,10 +1,13 @@
 #include <iostream>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <tnn/core/tnn.h>
 #include <tnn/core/instance.h>
 #include <tnn/core/mat.h>
 #include <tnn/utils/blob_converter.h>
 
+#include "mei/image_preprocess.h"
+
 using namespace TNN_NS;
 
 int main(int argc, char** argv) {
@@ -39,16 +42,19 @@ int main(int argc, char** argv) {
         std::cout << "Failed to load image: " << image_path << std::endl;
         return -1;
     }
-    cv::Mat resized;
-    cv::resize(image, resized, cv::Size(640, 640));
-    cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
+    // Letterbox into the 114 padded 640x640 input, BGR -> RGB, /255 and
+    // HWC -> CHW in one pass.
+    std::vector<float> input_data(1 * 3 * 640 * 640);
+    const float mean[3] = {0.f, 0.f, 0.f};
+    const float norm[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
+    const mei::ImageView view{image.data, image.cols, image.rows, static_cast<int>(image.step), mei::PixelFormat::BGR};
+    mei::letterbox_normalize(view, 640, 640, mei::PixelFormat::RGB, mean, norm, 114.f, mei::Layout::NCHW,
+                             input_data.data());
 
     DimsVector input_shape = {1, 3, 640, 640};
-    std::shared_ptr<Mat> input_mat = std::make_shared<Mat>(DEVICE_ARM, NCHW_FLOAT, input_shape, resized.data);
+    std::shared_ptr<Mat> input_mat = std::make_shared<Mat>(DEVICE_ARM, NCHW_FLOAT, input_shape, input_data.data());
 
     MatConvertParam input_param;
-    input_param.scale = {1/255.f, 1/255.f, 1/255.f, 0.f};
-    input_param.bias = {0.f, 0.f, 0.f, 0.f};
 
     status = instance->SetInputMat(input_mat, input_param);
     if (status != TNN_OK) {
@@ -0,0 +1,374 @@
+#include "mei/autotune.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include "mei/engine_registry.h"
+#include "mei/model_spec.h"
+
+namespace mei {
+
+TuneProfile& TuneProfile::instance() {
+    static TuneProfile profile = [] {
+        TuneProfile p;
+        const char* path = getenv("MEI_TUNE_PROFILE");
+        if (path && *path && !p.load(path)) {
+            std::cerr << "Autotune: could not read profile " << path << std::endl;
+        }
+        return p;
+    }();
+    return profile;
+}
+
+static bool parse_field(const std::string& key, const std::string& value, TuneEntry& e) {
+    int v = atoi(value.c_str());
+    if (key == "engine") e.engine = value;
+    else if (key == "threads") e.config.num_threads = v;
+    else if (key == "ncnn_winograd") e.config.ncnn_winograd = v != 0;
+    else if (key == "ncnn_sgemm") e.config.ncnn_sgemm = v != 0;
+    else if (key == "ncnn_packing") e.config.ncnn_packing = v != 0;
+    else if (key == "ort_graph_opt_level") e.config.ort_graph_opt_level = v;
+    else if (key == "tflite_xnnpack") e.config.tflite_xnnpack = v != 0;
+    else if (key == "mnn_precision") e.config.mnn_precision = v;
+    else if (key == "ms") e.avg_ms = atof(value.c_str());
+    else return false;
+    return true;
+}
+
+bool TuneProfile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        TuneEntry e;
+        ss >> e.model;
+        std::string token;
+        while (ss >> token) {
+            size_t eq = token.find('=');
+            if (eq == std::string::npos) continue;
+            const std::string key = token.substr(0, eq);
+            if (key == "model_path") {
+                std::string rest;
+                std::getline(ss, rest);
+                e.model_path = token.substr(eq + 1) + rest;
+                break;
+            }
+            if (!parse_field(key, token.substr(eq + 1), e)) {
+                std::cerr << "Autotune: ignoring unknown key " << key << " in " << path << std::endl;
+            }
+        }
+        if (!e.model.empty() && !e.model_path.empty() && !e.engine.empty()) {
+            set(e);
+        }
+    }
+    return true;
+}
+
+bool TuneProfile::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << "# mei autotune profile, written by mei_autotune\n";
+    for (const TuneEntry& e : entries_) {
+        const EngineConfig& c = e.config;
+        file << e.model << " engine=" << e.engine << " threads=" << c.num_threads
+             << " ncnn_winograd=" << c.ncnn_winograd << " ncnn_sgemm=" << c.ncnn_sgemm
+             << " ncnn_packing=" << c.ncnn_packing << " ort_graph_opt_level=" << c.ort_graph_opt_level
+             << " tflite_xnnpack=" << c.tflite_xnnpack << " mnn_precision=" << c.mnn_precision
+             << " ms=" << e.avg_ms << " model_path=" << e.model_path << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+const TuneEntry* TuneProfile::find(const std::string& model) const {
+    for (const TuneEntry& e : entries_) {
+        if (e.model == model) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+void TuneProfile::set(const TuneEntry& entry) {
+    for (TuneEntry& e : entries_) {
+        if (e.model == entry.model) {
+            e = entry;
+            return;
+        }
+    }
+    entries_.push_back(entry);
+}
+
+std::string tune_key(const std::string& model_path) {
+    if (const ModelSpec* spec = find_model_spec_for_model(model_path)) {
+        return spec->name;
+    }
+    size_t slash = model_path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? model_path : model_path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        name = name.substr(0, dot);
+    }
+    for (const char* suffix : {"_float16", "_float32"}) {
+        const size_t n = strlen(suffix);
+        if (name.size() > n && name.compare(name.size() - n, n, suffix) == 0) {
+            name.resize(name.size() - n);
+        }
+    }
+    return name;
+}
+
+std::vector<EngineConfig> tune_candidates(const std::string& engine, int max_threads) {
+    std::vector<int> threads;
+    for (int t = 1; t < max_threads; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(std::max(max_threads, 1));
+
+    std::vector<EngineConfig> configs;
+    for (int t : threads) {
+        EngineConfig base;
+        base.num_threads = t;
+        if (engine == "ncnn") {
+            for (int bits = 0; bits < 8; bits++) {
+                EngineConfig c = base;
+                c.ncnn_winograd = bits & 1;
+                c.ncnn_sgemm = bits & 2;
+                c.ncnn_packing = bits & 4;
+                configs.push_back(c);
+            }
+        } else if (engine == "onnxruntime") {
+            for (int level : {1, 2, 99}) {
+                EngineConfig c = base;
+                c.ort_graph_opt_level = level;
+                configs.push_back(c);
+            }
+        } else if (engine == "tflite") {
+            for (bool xnnpack : {false, true}) {
+                EngineConfig c = base;
+                c.tflite_xnnpack = xnnpack;
+                configs.push_back(c);
+            }
+        } else if (engine == "mnn") {
+            for (int precision : {0, 1, 2}) {
+                EngineConfig c = base;
+                c.mnn_precision = precision;
+                configs.push_back(c);
+            }
+        } else {
+            configs.push_back(base);
+        }
+    }
+    return configs;
+}
+
+// Declared input shape with dynamic dimensions taken from the spec (ncnn never
+// declares any). Empty if a dimension stays unknown.
+static std::vector<int64_t> concrete_shape(const Engine& engine, size_t index, const ModelSpec* spec) {
+    std::vector<int64_t> shape = engine.input_shapes()[index];
+    if (spec && shape.size() == 4) {
+        const bool nhwc = engine.input_layouts()[index] == Layout::NHWC;
+        const int64_t dims[4] = {1, nhwc ? spec->input_height : spec->input_channels(),
+                                 nhwc ? spec->input_width : spec->input_height,
+                                 nhwc ? spec->input_channels() : spec->input_width};
+        for (int d = 0; d < 4; d++) {
+            if (shape[d] <= 0) shape[d] = dims[d];
+        }
+    }
+    for (int64_t d : shape) {
+        if (d <= 0) return {};
+    }
+    return shape;
+}
+
+// Fixed pseudo-random bytes, the same for every run of a model: zeros leave
+// most of the weights out of the output check.
+static void fill_input(const TensorView& view, std::vector<uint8_t>& buffer) {
+    buffer.resize(view.storage_bytes());
+    uint32_t state = 2463534242u;
+    auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    if (view.dtype == DataType::Float32) {
+        float* values = reinterpret_cast<float*>(buffer.data());
+        for (size_t i = 0; i < buffer.size() / sizeof(float); i++) {
+            values[i] = static_cast<float>(next() >> 8) / (1 << 23) - 1.f;
+        }
+        return;
+    }
+    for (uint8_t& b : buffer) {
+        b = static_cast<uint8_t>(next() >> 24);
+    }
+}
+
+// Dense float32 copy of an output, dequantized if the model is quantized.
+static bool output_values(const TensorView& out, std::vector<float>& values) {
+    values.resize(static_cast<size_t>(out.element_count()));
+    if (out.dtype == DataType::UInt8 || out.dtype == DataType::Int8) {
+        return dequantize(out, values.data());
+    }
+    const TensorView dense = TensorView::dense(values.data(), out.shape, out.ndim, DataType::Float32,
+                                               out.layout == Layout::NC4HW4 ? Layout::NCHW : out.layout);
+    return out.dtype == DataType::Float32 && copy_tensor(out, dense);
+}
+
+double benchmark_model(const std::string& model_path, const EngineConfig& config, int runs,
+                       std::vector<std::vector<float>>* outputs) {
+    std::unique_ptr<Engine> engine = create_engine_for_model(model_path);
+    if (!engine || !engine->load(model_files_for(model_path), config)) {
+        return -1.0;
+    }
+    const ModelSpec* spec = find_model_spec_for_model(model_path);
+    // Inputs in the model's own input types, so quantized models are fed
+    // UInt8 / Int8 as they would be at runtime.
+    std::vector<std::vector<uint8_t>> buffers(engine->input_shapes().size());
+    std::vector<TensorView> inputs;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        const std::vector<int64_t> shape = concrete_shape(*engine, i, spec);
+        if (shape.empty()) {
+            std::cerr << "Autotune: " << model_path << " has a dynamic input shape" << std::endl;
+            return -1.0;
+        }
+        TensorView view = TensorView::dense(nullptr, shape, engine->input_dtype(i), engine->input_layouts()[i]);
+        view.quant = engine->input_quant(i);
+        fill_input(view, buffers[i]);
+        view.data = buffers[i].data();
+        inputs.push_back(view);
+    }
+
+    std::vector<TensorView> results;
+    // Engines that cannot warm up dynamic shapes themselves get one run here.
+    if (!engine->infer(inputs, results)) {
+        return -1.0;
+    }
+    std::vector<double> times;
+    for (int r = 0; r < std::max(runs, 1); r++) {
+        auto start = std::chrono::steady_clock::now();
+        if (!engine->infer(inputs, results)) {
+            return -1.0;
+        }
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    if (outputs) {
+        outputs->resize(results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!output_values(results[i], (*outputs)[i])) {
+                std::cerr << "Autotune: " << model_path << " output " << i << " cannot be read back" << std::endl;
+                return -1.0;
+            }
+        }
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+bool lower_precision_file(const std::string& model_path) {
+    size_t slash = model_path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? model_path : model_path.substr(slash + 1);
+    const size_t dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        name.resize(dot);
+    }
+    for (const char* suffix : {"_float16", "_fp16", "_int8", "_quant"}) {
+        const size_t n = strlen(suffix);
+        if (name.size() > n && name.compare(name.size() - n, n, suffix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Largest difference between two runs' outputs, relative to the largest
+// magnitude of each reference output (at least 1). Infinite if they do not
+// even have the same shapes, or on NaN.
+static float output_error(const std::vector<std::vector<float>>& reference,
+                          const std::vector<std::vector<float>>& outputs) {
+    if (reference.size() != outputs.size()) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float error = 0.f;
+    for (size_t i = 0; i < reference.size(); i++) {
+        if (reference[i].size() != outputs[i].size()) {
+            return std::numeric_limits<float>::infinity();
+        }
+        float range = 1.f, diff = 0.f;
+        for (size_t j = 0; j < reference[i].size(); j++) {
+            const float d = std::fabs(reference[i][j] - outputs[i][j]);
+            if (std::isnan(d)) {
+                return std::numeric_limits<float>::infinity();
+            }
+            range = std::max(range, std::fabs(reference[i][j]));
+            diff = std::max(diff, d);
+        }
+        error = std::max(error, diff / range);
+    }
+    return error;
+}
+
+bool autotune(const std::vector<std::string>& model_paths, const TuneOptions& options, TuneEntry& best) {
+    int max_threads = options.max_threads > 0 ? options.max_threads
+                                              : static_cast<int>(std::thread::hardware_concurrency());
+    bool found = false;
+    for (const std::string& path : model_paths) {
+        const char* engine = EngineRegistry::instance().engine_for_model(path);
+        if (!engine) {
+            if (options.verbose) printf("  %s: no enabled engine, skipped\n", path.c_str());
+            continue;
+        }
+        if (!options.allow_lower_precision && lower_precision_file(path)) {
+            if (options.verbose) printf("  %s: lower precision file, skipped\n", path.c_str());
+            continue;
+        }
+        // What the file produces with the defaults the examples use.
+        std::vector<std::vector<float>> reference, outputs;
+        if (!options.allow_lower_precision && benchmark_model(path, EngineConfig(), 1, &reference) < 0) {
+            if (options.verbose) printf("  %s: default config failed, skipped\n", path.c_str());
+            continue;
+        }
+        for (const EngineConfig& config : tune_candidates(engine, max_threads)) {
+            double ms = benchmark_model(path, config, options.runs,
+                                        options.allow_lower_precision ? nullptr : &outputs);
+            const float error = ms < 0 || options.allow_lower_precision ? 0.f : output_error(reference, outputs);
+            if (options.verbose) {
+                printf("  %-12s threads=%d winograd=%d sgemm=%d packing=%d ort_opt=%d xnnpack=%d mnn_prec=%d : ",
+                       engine, config.num_threads, config.ncnn_winograd, config.ncnn_sgemm, config.ncnn_packing,
+                       config.ort_graph_opt_level, config.tflite_xnnpack, config.mnn_precision);
+                if (ms < 0) printf("failed  %s\n", path.c_str());
+                else if (error > options.max_output_error) printf("outputs off by %g  %s\n", error, path.c_str());
+                else printf("%8.3f ms  %s\n", ms, path.c_str());
+            }
+            if (ms < 0 || error > options.max_output_error) {
+                continue;
+            }
+            if (!found || ms < best.avg_ms) {
+                best.model = tune_key(path);
+                best.model_path = path;
+                best.engine = engine;
+                best.config = config;
+                best.avg_ms = ms;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+} // namespace mei
@@ -1,6 +0,0 @@
-// This is a dummy file to ensure the library can be built.
-// We will replace this with actual implementation later.
-
-void multi_engine_inference_dummy() {
-    // Do nothing.
-} 
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "mei/engine.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "mei/engine_registry.h"
+#include "mei/thread_pool.h"
+
+namespace mei {
+
+bool Engine::warmup(const EngineConfig& config) {
+    if (config.warmup_runs <= 0) {
+        return true;
+    }
+    std::vector<std::vector<uint8_t>> inputs(input_shapes_.size());
+    std::vector<TensorView> views;
+    for (size_t i = 0; i < input_shapes_.size(); i++) {
+        for (int64_t d : input_shapes_[i]) {
+            // Nothing sensible to warm up with until the caller picks a shape.
+            if (d <= 0) {
+                return true;
+            }
+        }
+        TensorView view = TensorView::dense(nullptr, input_shapes_[i], input_dtype(i));
+        view.quant = input_quant(i);
+        inputs[i].assign(view.storage_bytes(), 0);
+        view.data = inputs[i].data();
+        views.push_back(view);
+    }
+    std::vector<TensorView> outputs;
+    for (int i = 0; i < config.warmup_runs; i++) {
+        if (!infer(views, outputs)) {
+            std::cerr << name() << ": warmup forward failed" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Engine::reset_io() {
+    if (budgeted_) {
+        ThreadBudget::instance().detach(this);
+        budgeted_ = false;
+        grant_pending_ = false;
+        granted_threads_ = 1;
+    }
+    loaded_ = false;
+    input_names_.clear();
+    output_names_.clear();
+    input_shapes_.clear();
+    input_layouts_.clear();
+    input_dtypes_.clear();
+    input_quantization_.clear();
+    staging_.clear();
+    input_views_.clear();
+    input_buffers_.clear();
+}
+
+ThreadGrant Engine::join_thread_budget(const EngineConfig& config) {
+    if (budgeted_) {
+        ThreadBudget::instance().detach(this);
+    }
+    budgeted_ = true;
+    const ThreadGrant grant = ThreadBudget::instance().attach(this, config.num_threads);
+    granted_threads_ = grant.num_threads;
+    return grant;
+}
+
+void Engine::post_thread_grant(const ThreadGrant& grant) {
+    std::lock_guard<std::mutex> lock(grant_mutex_);
+    pending_grant_ = grant;
+    grant_pending_ = true;
+    granted_threads_ = grant.num_threads;
+}
+
+void Engine::apply_thread_grant(const std::vector<TensorView>& inputs) {
+    if (!grant_pending_.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (is_input_view(i, inputs[i])) {
+            return;
+        }
+    }
+    ThreadGrant grant;
+    {
+        std::lock_guard<std::mutex> lock(grant_mutex_);
+        grant = pending_grant_;
+        grant_pending_ = false;
+    }
+    set_threads(grant);
+}
+
+TensorView Engine::input_view(size_t index, const std::vector<int64_t>& shape) {
+    bool valid = loaded_ && index < input_names_.size() && !shape.empty() &&
+                 shape.size() <= static_cast<size_t>(TensorView::kMaxDims);
+    for (int64_t d : shape) {
+        valid = valid && d > 0;
+    }
+    if (!valid) {
+        std::cerr << name() << ": no input view for input " << index << std::endl;
+        return TensorView();
+    }
+    apply_thread_grant({});
+    if (input_views_.size() <= index) {
+        input_views_.resize(index + 1);
+    }
+    input_views_[index] = bind_input(index, shape);
+    return input_views_[index];
+}
+
+TensorView Engine::bind_input(size_t index, const std::vector<int64_t>& shape) {
+    TensorView view = TensorView::dense(nullptr, shape, input_dtype(index), input_layouts_[index]);
+    view.quant = input_quant(index);
+    if (input_buffers_.size() <= index) {
+        input_buffers_.resize(index + 1);
+    }
+    input_buffers_[index].resize(view.storage_bytes());
+    view.data = input_buffers_[index].data();
+    return view;
+}
+
+bool Engine::is_input_view(size_t index, const TensorView& in) const {
+    return in.data && index < input_views_.size() && in.data == input_views_[index].data;
+}
+
+DataType Engine::input_dtype(size_t index) const {
+    return index < input_dtypes_.size() ? input_dtypes_[index] : DataType::Float32;
+}
+
+Quantization Engine::input_quant(size_t index) const {
+    return index < input_quantization_.size() ? input_quantization_[index] : Quantization();
+}
+
+TensorView Engine::native_input(size_t index, const TensorView& in) {
+    if (is_input_view(index, in)) {
+        return in;
+    }
+    const Layout native = index < input_layouts_.size() ? input_layouts_[index] : Layout::Any;
+    if (in.is_dense() && (in.layout == Layout::Any || in.layout == native)) {
+        return in;
+    }
+
+    // Permute the shape into the native order, then convert into staging.
+    int64_t shape[TensorView::kMaxDims];
+    for (int i = 0; i < in.ndim; i++) shape[i] = in.shape[i];
+    if (in.ndim == 4 && in.layout == Layout::NHWC && native != Layout::NHWC && native != Layout::Any) {
+        shape[1] = in.shape[3]; shape[2] = in.shape[1]; shape[3] = in.shape[2];
+    } else if (in.ndim == 4 && in.layout != Layout::NHWC && native == Layout::NHWC) {
+        shape[1] = in.shape[2]; shape[2] = in.shape[3]; shape[3] = in.shape[1];
+    }
+    const Layout target = native == Layout::Any ? in.layout : native;
+    if (staging_.size() <= index) {
+        staging_.resize(index + 1);
+    }
+    TensorView out = TensorView::dense(nullptr, shape, in.ndim, in.dtype, target);
+    out.quant = in.quant;
+    staging_[index].resize(out.storage_bytes());
+    out.data = staging_[index].data();
+    if (!copy_tensor(in, out)) {
+        std::cerr << name() << ": cannot convert input " << index << " to the native layout" << std::endl;
+        return TensorView();
+    }
+    return out;
+}
+
+void Engine::submit(const std::vector<TensorView>& inputs, InferCallback done) {
+    AsyncJob job{inputs, std::move(done)};
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        if (async_busy_) {
+            async_queue_.push_back(std::move(job));
+            return;
+        }
+        async_busy_ = true;
+    }
+    start_job(std::move(job));
+}
+
+std::future<bool> Engine::submit(const std::vector<TensorView>& inputs, std::vector<Tensor>& outputs) {
+    std::shared_ptr<std::promise<bool>> promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = promise->get_future();
+    submit(inputs, [promise, &outputs](bool ok, const std::vector<TensorView>& views) {
+        outputs.resize(views.size());
+        for (size_t i = 0; ok && i < views.size(); i++) {
+            const TensorView& v = views[i];
+            Tensor& t = outputs[i];
+            t.shape = v.shape_vector();
+            t.layout = v.layout == Layout::NC4HW4 ? Layout::NCHW : v.layout;
+            t.data.resize(static_cast<size_t>(v.element_count()));
+            ok = v.dtype == DataType::Float32 && copy_tensor(v, t.view());
+        }
+        promise->set_value(ok);
+    });
+    return future;
+}
+
+void Engine::wait_idle() {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    async_idle_.wait(lock, [this] { return !async_busy_; });
+}
+
+void Engine::start_job(AsyncJob job) {
+    std::shared_ptr<AsyncJob> shared = std::make_shared<AsyncJob>(std::move(job));
+    ThreadPool::shared().enqueue([this, shared] {
+        std::vector<TensorView> outputs;
+        const bool ok = infer(shared->inputs, outputs);
+        shared->done(ok, outputs);
+        finish_job();
+    });
+}
+
+void Engine::finish_job() {
+    AsyncJob next;
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        if (async_queue_.empty()) {
+            async_busy_ = false;
+            async_idle_.notify_all();
+            return;
+        }
+        next = std::move(async_queue_.front());
+        async_queue_.pop_front();
+    }
+    start_job(std::move(next));
+}
+
+std::unique_ptr<Engine> create_engine(const std::string& name) {
+    std::unique_ptr<Engine> engine = EngineRegistry::instance().create(name);
+    if (!engine) {
+        std::cerr << "Unknown or disabled engine: " << name << std::endl;
+    }
+    return engine;
+}
+
+std::unique_ptr<Engine> create_engine_for_model(const std::string& model_path) {
+    std::unique_ptr<Engine> engine = EngineRegistry::instance().create_for_model(model_path);
+    if (!engine) {
+        std::cerr << "No enabled engine handles " << model_path << std::endl;
+    }
+    return engine;
+}
+
+ModelFiles model_files_for(const std::string& model_path) {
+    static const char* const kPairs[][2] = {
+        {".param", ".bin"},
+        {".tnnproto", ".tnnmodel"},
+    };
+    ModelFiles files;
+    files.model_path = model_path;
+    for (const auto& pair : kPairs) {
+        const size_t n = strlen(pair[0]);
+        if (model_path.size() > n && model_path.compare(model_path.size() - n, n, pair[0]) == 0) {
+            files.weights_path = model_path.substr(0, model_path.size() - n) + pair[1];
+        }
+    }
+    return files;
+}
+
+} // namespace mei
@@ -0,0 +1,77 @@
+#include "mei/engine_registry.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace mei {
+
+static std::string extension_of(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return std::string();
+    }
+    return path.substr(dot);
+}
+
+EngineRegistry& EngineRegistry::instance() {
+    static EngineRegistry registry;
+    return registry;
+}
+
+void EngineRegistry::add(const char* name, EngineFactory factory, std::initializer_list<const char*> extensions) {
+    if (count_ >= kMaxEngines) {
+        std::cerr << "EngineRegistry: too many engines, dropping " << name << std::endl;
+        return;
+    }
+    Entry& entry = entries_[count_++];
+    entry.name = name;
+    entry.factory = factory;
+    int n = 0;
+    for (const char* ext : extensions) {
+        if (n == kMaxExtensions) break;
+        entry.extensions[n++] = ext;
+    }
+    for (; n < kMaxExtensions; n++) {
+        entry.extensions[n] = nullptr;
+    }
+}
+
+std::unique_ptr<Engine> EngineRegistry::create(const std::string& name) const {
+    for (int i = 0; i < count_; i++) {
+        if (name == entries_[i].name) {
+            return entries_[i].factory();
+        }
+    }
+    return nullptr;
+}
+
+const char* EngineRegistry::engine_for_model(const std::string& model_path) const {
+    const std::string ext = extension_of(model_path);
+    if (ext.empty()) {
+        return nullptr;
+    }
+    for (int i = 0; i < count_; i++) {
+        for (const char* e : entries_[i].extensions) {
+            if (e && ext == e) {
+                return entries_[i].name;
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<Engine> EngineRegistry::create_for_model(const std::string& model_path) const {
+    const char* name = engine_for_model(model_path);
+    return name ? create(name) : nullptr;
+}
+
+std::vector<std::string> EngineRegistry::names() const {
+    std::vector<std::string> result;
+    for (int i = 0; i < count_; i++) {
+        result.push_back(entries_[i].name);
+    }
+    return result;
+}
+
+} // namespace mei
@@ -0,0 +1,218 @@
+#include "engines/mnn_engine.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "mei/engine_registry.h"
+
+namespace mei {
+
+static std::vector<int64_t> to_shape(const std::vector<int>& dims) {
+    return std::vector<int64_t>(dims.begin(), dims.end());
+}
+
+static Layout to_layout(const MNN::Tensor* t) {
+    switch (t->getDimensionType()) {
+    case MNN::Tensor::TENSORFLOW: return Layout::NHWC;
+    case MNN::Tensor::CAFFE_C4: return Layout::NC4HW4;
+    default: return t->dimensions() == 4 ? Layout::NCHW : Layout::Any;
+    }
+}
+
+static bool to_dtype(halide_type_t type, DataType& dtype) {
+    if (type.code == halide_type_float && type.bits == 32) dtype = DataType::Float32;
+    else if (type.code == halide_type_uint && type.bits == 8) dtype = DataType::UInt8;
+    else if (type.code == halide_type_int && type.bits == 8) dtype = DataType::Int8;
+    else if (type.code == halide_type_int && type.bits == 32) dtype = DataType::Int32;
+    else return false;
+    return true;
+}
+
+// View of a session tensor's own host memory, no copy.
+static TensorView host_view(const MNN::Tensor* t) {
+    DataType dtype = DataType::Float32;
+    to_dtype(t->getType(), dtype);
+    return TensorView::dense(t->host<void>(), to_shape(t->shape()), dtype, to_layout(t));
+}
+
+bool MnnEngine::load(const ModelFiles& files, const EngineConfig& config) {
+    unload();
+    net_.reset(MNN::Interpreter::createFromFile(files.model_path.c_str()));
+    if (!net_) {
+        std::cerr << "MNN: failed to load model " << files.model_path << std::endl;
+        return false;
+    }
+    schedule_ = MNN::ScheduleConfig();
+    schedule_.type = MNN_FORWARD_CPU;
+    schedule_.numThread = join_thread_budget(config).num_threads;
+    backend_config_ = MNN::BackendConfig();
+    backend_config_.precision = static_cast<MNN::BackendConfig::PrecisionMode>(config.mnn_precision);
+    schedule_.backendConfig = &backend_config_;
+    MNN::Session* session = net_->createSession(schedule_);
+    if (!session) {
+        std::cerr << "MNN: failed to create session for " << files.model_path << std::endl;
+        unload();
+        return false;
+    }
+
+    ShapeKey key;
+    for (const auto& kv : net_->getSessionInputAll(session)) {
+        input_names_.push_back(kv.first);
+        input_shapes_.push_back(to_shape(kv.second->shape()));
+        // Callers provide NCHW even when the session stores NC4HW4, the
+        // packing is done while copying into the session tensor.
+        Layout layout = to_layout(kv.second);
+        input_layouts_.push_back(layout == Layout::NC4HW4 ? Layout::NCHW : layout);
+        input_dtypes_.push_back(DataType::Float32);
+        input_quantization_.push_back(Quantization());
+        key.push_back(static_cast<int64_t>(input_shapes_.back().size()));
+        key.insert(key.end(), input_shapes_.back().begin(), input_shapes_.back().end());
+    }
+    for (const auto& kv : net_->getSessionOutputAll(session)) {
+        output_names_.push_back(kv.first);
+    }
+    sessions_.set_capacity(config.shape_cache_size);
+    active_ = &sessions_.insert(key, wrap_session(session));
+    active_key_ = key;
+    loaded_ = true;
+    return warmup(config);
+}
+
+MnnEngine::ShapeSession MnnEngine::wrap_session(MNN::Session* session) {
+    ShapeSession s;
+    s.session = std::unique_ptr<MNN::Session, SessionDeleter>(session, SessionDeleter{net_.get()});
+    for (const auto& name : input_names_) {
+        s.inputs.push_back(net_->getSessionInput(session, name.c_str()));
+    }
+    for (const auto& name : output_names_) {
+        s.outputs.push_back(net_->getSessionOutput(session, name.c_str()));
+    }
+    s.host_outputs.resize(s.outputs.size());
+    return s;
+}
+
+bool MnnEngine::activate(const std::vector<TensorView>& native) {
+    ShapeKey key = make_shape_key(native);
+    if (key == active_key_) {
+        return true;
+    }
+    ShapeSession* cached = sessions_.find(key);
+    if (!cached) {
+        // Each shape gets its own session, so coming back to it later needs
+        // neither resizeTensor nor the memory re-planning of resizeSession.
+        MNN::Session* session = net_->createSession(schedule_);
+        if (!session) {
+            std::cerr << "MNN: failed to create session" << std::endl;
+            return false;
+        }
+        ShapeSession fresh = wrap_session(session);
+        for (size_t i = 0; i < native.size(); i++) {
+            net_->resizeTensor(fresh.inputs[i], std::vector<int>(native[i].shape, native[i].shape + native[i].ndim));
+        }
+        net_->resizeSession(session);
+        cached = &sessions_.insert(key, std::move(fresh));
+    }
+    active_ = cached;
+    active_key_ = std::move(key);
+    return true;
+}
+
+TensorView MnnEngine::bind_input(size_t index, const std::vector<int64_t>& shape) {
+    // Sessions are keyed by the whole input set, only a lone input selects one.
+    if (input_names_.size() == 1) {
+        const std::vector<TensorView> native(1, TensorView::dense(nullptr, shape, DataType::Float32, input_layouts_[0]));
+        if (activate(native)) {
+            const MNN::Tensor* t = active_->inputs[0];
+            const TensorView view = host_view(t);
+            if (view.data && view.layout != Layout::NC4HW4 && view.dtype == DataType::Float32 &&
+                view.shape_vector() == shape) {
+                return view;
+            }
+        }
+    }
+    return Engine::bind_input(index, shape);
+}
+
+bool MnnEngine::infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) {
+    if (!loaded_ || inputs.size() != input_names_.size()) {
+        std::cerr << "MNN: expected " << input_names_.size() << " inputs, got " << inputs.size() << std::endl;
+        return false;
+    }
+    apply_thread_grant(inputs);
+
+    std::vector<TensorView> native(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        native[i] = native_input(i, inputs[i]);
+        if (!native[i].data) {
+            return false;
+        }
+    }
+    if (!activate(native)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        MNN::Tensor* t = active_->inputs[i];
+        if (t->host<void>() && native[i].data == t->host<void>()) {
+            // Written in place through input_view().
+            continue;
+        }
+        if (t->host<void>()) {
+            // CPU session: write straight into the session tensor, packing to
+            // NC4HW4 on the way if that is what the session uses.
+            TensorView dst = host_view(t);
+            if (!copy_tensor(native[i], dst)) {
+                std::cerr << "MNN: input " << input_names_[i] << " does not match the session tensor" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        MNN::Tensor host(t, t->getDimensionType() == MNN::Tensor::TENSORFLOW ? MNN::Tensor::TENSORFLOW : MNN::Tensor::CAFFE);
+        if (host.usize() != native[i].storage_bytes()) {
+            std::cerr << "MNN: input " << input_names_[i] << " size mismatch" << std::endl;
+            return false;
+        }
+        memcpy(host.host<void>(), native[i].data, host.usize());
+        t->copyFromHostTensor(&host);
+    }
+
+    if (net_->runSession(active_->session.get()) != MNN::NO_ERROR) {
+        std::cerr << "MNN: runSession failed" << std::endl;
+        return false;
+    }
+
+    outputs.resize(active_->outputs.size());
+    for (size_t i = 0; i < active_->outputs.size(); i++) {
+        MNN::Tensor* t = active_->outputs[i];
+        if (!t->host<void>()) {
+            std::unique_ptr<MNN::Tensor>& host = active_->host_outputs[i];
+            if (!host || host->shape() != t->shape()) {
+                host.reset(new MNN::Tensor(t, t->getDimensionType()));
+            }
+            t->copyToHostTensor(host.get());
+            t = host.get();
+        }
+        outputs[i] = host_view(t);
+    }
+    return true;
+}
+
+void MnnEngine::set_threads(const ThreadGrant& grant) {
+    schedule_.numThread = grant.num_threads;
+    active_ = nullptr;
+    active_key_.clear();
+    sessions_.clear();
+}
+
+void MnnEngine::unload() {
+    wait_idle();
+    active_ = nullptr;
+    active_key_.clear();
+    sessions_.clear();
+    net_.reset();
+    reset_io();
+}
+
+MEI_REGISTER_ENGINE("mnn", MnnEngine, ".mnn");
+
+} // namespace mei
@@ -0,0 +1,61 @@
+#ifndef MEI_ENGINES_MNN_ENGINE_H_
+#define MEI_ENGINES_MNN_ENGINE_H_
+
+#include <memory>
+#include <vector>
+
+#include <MNN/Interpreter.hpp>
+#include <MNN/Tensor.hpp>
+
+#include "lru_cache.h"
+#include "mei/engine.h"
+
+namespace mei {
+
+class MnnEngine : public Engine {
+public:
+    ~MnnEngine() override { unload(); }
+
+    const char* name() const override { return "mnn"; }
+
+    bool load(const ModelFiles& files, const EngineConfig& config) override;
+    bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) override;
+    void unload() override;
+
+protected:
+    // The session input tensor, when it has host memory that is not NC4HW4.
+    TensorView bind_input(size_t index, const std::vector<int64_t>& shape) override;
+    // numThread is fixed per session: the cached sessions are dropped and
+    // recreated with the new count on demand.
+    void set_threads(const ThreadGrant& grant) override;
+
+private:
+    struct SessionDeleter {
+        MNN::Interpreter* net;
+        void operator()(MNN::Session* session) const { net->releaseSession(session); }
+    };
+    // A session resized for one input shape set.
+    struct ShapeSession {
+        std::unique_ptr<MNN::Session, SessionDeleter> session;
+        std::vector<MNN::Tensor*> inputs;
+        std::vector<MNN::Tensor*> outputs;
+        // Only used when a session tensor has no host pointer (non CPU backends).
+        std::vector<std::unique_ptr<MNN::Tensor>> host_outputs;
+    };
+
+    ShapeSession wrap_session(MNN::Session* session);
+    // Makes the session for `native`'s shapes active, creating it on a miss.
+    bool activate(const std::vector<TensorView>& native);
+
+    std::shared_ptr<MNN::Interpreter> net_;
+    MNN::ScheduleConfig schedule_;
+    MNN::BackendConfig backend_config_;
+    // Declared after net_ so the sessions are released before the interpreter.
+    LruCache<ShapeKey, ShapeSession> sessions_;
+    ShapeSession* active_ = nullptr;
+    ShapeKey active_key_;
+};
+
+} // namespace mei
+
+#endif // MEI_ENGINES_MNN_ENGINE_H_
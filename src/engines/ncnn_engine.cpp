@@ -0,0 +1,174 @@
+#include "engines/ncnn_engine.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "mei/engine_registry.h"
+
+namespace mei {
+
+// ncnn has no batch axis, tensors are handed over as batch 1. The caller's
+// buffer is wrapped in place when its channel pitch matches ncnn's 16 byte
+// aligned cstep, which holds for every model input in assets/.
+static bool to_ncnn_mat(const TensorView& v, ncnn::Mat& mat) {
+    if (v.ndim < 2 || v.ndim > 5 || v.shape[0] != 1 || v.dtype != DataType::Float32 || !v.is_dense()) {
+        return false;
+    }
+    const int64_t* s = v.shape;
+    float* data = v.ptr<float>();
+    switch (v.ndim) {
+    case 2: mat = ncnn::Mat((int)s[1], (void*)data); return true;
+    case 3: mat = ncnn::Mat((int)s[2], (int)s[1], (void*)data); return true;
+    case 4: mat = ncnn::Mat((int)s[3], (int)s[2], (int)s[1], (void*)data); break;
+    default: mat = ncnn::Mat((int)s[4], (int)s[3], (int)s[2], (int)s[1], (void*)data); break;
+    }
+    const size_t plane = (size_t)mat.w * mat.h * mat.d;
+    if (mat.cstep == plane) {
+        return true;
+    }
+    ncnn::Mat packed;
+    packed.create_like(mat);
+    for (int c = 0; c < mat.c; c++) {
+        memcpy(packed.channel(c), data + c * plane, plane * sizeof(float));
+    }
+    mat = packed;
+    return true;
+}
+
+static TensorView from_ncnn_mat(const ncnn::Mat& m) {
+    TensorView v;
+    v.data = m.data;
+    v.dtype = DataType::Float32;
+    const int64_t cstep = (int64_t)m.cstep;
+    switch (m.dims) {
+    case 1:
+        v.ndim = 2;
+        v.shape[0] = 1; v.shape[1] = m.w;
+        v.strides[0] = m.w; v.strides[1] = 1;
+        break;
+    case 2:
+        v.ndim = 3;
+        v.shape[0] = 1; v.shape[1] = m.h; v.shape[2] = m.w;
+        v.strides[0] = (int64_t)m.h * m.w; v.strides[1] = m.w; v.strides[2] = 1;
+        break;
+    case 3:
+        v.ndim = 4;
+        v.layout = Layout::NCHW;
+        v.shape[0] = 1; v.shape[1] = m.c; v.shape[2] = m.h; v.shape[3] = m.w;
+        v.strides[0] = m.c * cstep; v.strides[1] = cstep; v.strides[2] = m.w; v.strides[3] = 1;
+        break;
+    default:
+        v.ndim = 5;
+        v.shape[0] = 1; v.shape[1] = m.c; v.shape[2] = m.d; v.shape[3] = m.h; v.shape[4] = m.w;
+        v.strides[0] = m.c * cstep; v.strides[1] = cstep;
+        v.strides[2] = (int64_t)m.h * m.w; v.strides[3] = m.w; v.strides[4] = 1;
+        break;
+    }
+    return v;
+}
+
+bool NcnnEngine::load(const ModelFiles& files, const EngineConfig& config) {
+    unload();
+    net_.reset(new ncnn::Net());
+    net_->opt.use_vulkan_compute = false;
+    net_->opt.use_winograd_convolution = config.ncnn_winograd;
+    net_->opt.use_sgemm_convolution = config.ncnn_sgemm;
+    net_->opt.use_packing_layout = config.ncnn_packing;
+    if (net_->load_param(files.model_path.c_str()) != 0 || net_->load_model(files.weights_path.c_str()) != 0) {
+        std::cerr << "NCNN: failed to load model " << files.model_path << std::endl;
+        net_.reset();
+        return false;
+    }
+    set_threads(join_thread_budget(config));
+
+    input_indexes_ = net_->input_indexes();
+    output_indexes_ = net_->output_indexes();
+    for (const char* n : net_->input_names()) {
+        input_names_.push_back(n);
+        // Input layers rarely carry a static shape in the .param file.
+        input_shapes_.push_back({1, -1, -1, -1});
+        input_layouts_.push_back(Layout::NCHW);
+        input_dtypes_.push_back(DataType::Float32);
+        input_quantization_.push_back(Quantization());
+    }
+    for (const char* n : net_->output_names()) {
+        output_names_.push_back(n);
+    }
+    outputs_.resize(output_indexes_.size());
+    input_mats_.resize(input_indexes_.size());
+    loaded_ = true;
+    return warmup(config);
+}
+
+TensorView NcnnEngine::bind_input(size_t index, const std::vector<int64_t>& shape) {
+    if (shape.size() != 4 || shape[0] != 1) {
+        return Engine::bind_input(index, shape);
+    }
+    // create() keeps the allocation while the shape stays the same.
+    ncnn::Mat& mat = input_mats_[index];
+    mat.create(static_cast<int>(shape[3]), static_cast<int>(shape[2]), static_cast<int>(shape[1]));
+    return from_ncnn_mat(mat);
+}
+
+bool NcnnEngine::infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) {
+    if (!loaded_ || inputs.size() != input_indexes_.size()) {
+        std::cerr << "NCNN: expected " << input_indexes_.size() << " inputs, got " << inputs.size() << std::endl;
+        return false;
+    }
+
+    apply_thread_grant(inputs);
+    if (rebind_cpus_) {
+        ncnn::set_cpu_thread_affinity(cpu_set_);
+        rebind_cpus_ = false;
+    }
+
+    ncnn::Extractor ex = net_->create_extractor();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        ncnn::Mat in;
+        if (is_input_view(i, inputs[i]) && inputs[i].data == input_mats_[i].data) {
+            ex.input(input_indexes_[i], input_mats_[i]);
+            continue;
+        }
+        TensorView native = native_input(i, inputs[i]);
+        if (!native.data || !to_ncnn_mat(native, in)) {
+            std::cerr << "NCNN: unsupported tensor for input " << input_names_[i] << std::endl;
+            return false;
+        }
+        ex.input(input_indexes_[i], in);
+    }
+
+    outputs.resize(output_indexes_.size());
+    for (size_t i = 0; i < output_indexes_.size(); i++) {
+        if (ex.extract(output_indexes_[i], outputs_[i]) != 0) {
+            std::cerr << "NCNN: failed to extract " << output_names_[i] << std::endl;
+            return false;
+        }
+        outputs[i] = from_ncnn_mat(outputs_[i]);
+    }
+    return true;
+}
+
+void NcnnEngine::set_threads(const ThreadGrant& grant) {
+    net_->opt.num_threads = grant.num_threads;
+    if (!grant.cpus.empty()) {
+        cpu_set_.disable_all();
+        for (int cpu : grant.cpus) {
+            cpu_set_.enable(cpu);
+        }
+        rebind_cpus_ = true;
+    }
+}
+
+void NcnnEngine::unload() {
+    wait_idle();
+    outputs_.clear();
+    input_mats_.clear();
+    net_.reset();
+    input_indexes_.clear();
+    output_indexes_.clear();
+    reset_io();
+}
+
+MEI_REGISTER_ENGINE("ncnn", NcnnEngine, ".param");
+
+} // namespace mei
@@ -0,0 +1,45 @@
+#ifndef MEI_ENGINES_NCNN_ENGINE_H_
+#define MEI_ENGINES_NCNN_ENGINE_H_
+
+#include <memory>
+#include <vector>
+
+#include <cpu.h>
+#include <net.h>
+
+#include "mei/engine.h"
+
+namespace mei {
+
+class NcnnEngine : public Engine {
+public:
+    ~NcnnEngine() override { unload(); }
+
+    const char* name() const override { return "ncnn"; }
+
+    bool load(const ModelFiles& files, const EngineConfig& config) override;
+    bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) override;
+    void unload() override;
+
+protected:
+    // An input Mat of the shape (batch 1), handed to the extractor as is.
+    TensorView bind_input(size_t index, const std::vector<int64_t>& shape) override;
+    // Thread count goes into opt (read by every new extractor); the core set
+    // is bound on the thread that runs infer(), before its next extract.
+    void set_threads(const ThreadGrant& grant) override;
+
+private:
+    std::unique_ptr<ncnn::Net> net_;
+    std::vector<int> input_indexes_;
+    std::vector<int> output_indexes_;
+    // Backing of input_view().
+    std::vector<ncnn::Mat> input_mats_;
+    // Extracted blobs, the views returned by infer() point into them.
+    std::vector<ncnn::Mat> outputs_;
+    ncnn::CpuSet cpu_set_;
+    bool rebind_cpus_ = false;
+};
+
+} // namespace mei
+
+#endif // MEI_ENGINES_NCNN_ENGINE_H_
@@ -0,0 +1,254 @@
+#include "engines/onnxruntime_engine.h"
+
+#include <iostream>
+#include <string>
+
+#include <onnxruntime_session_options_config_keys.h>
+
+#include "mei/engine_registry.h"
+
+namespace mei {
+
+// One Ort::Env per process, shared by every session.
+static Ort::Env& ort_env() {
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "mei");
+    return env;
+}
+
+static ONNXTensorElementDataType to_onnx_type(DataType dtype) {
+    switch (dtype) {
+    case DataType::Float32: return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    case DataType::Float16: return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    case DataType::UInt8: return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+    case DataType::Int8: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    case DataType::Int32: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32;
+    case DataType::Int64: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+    }
+    return ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+}
+
+static DataType from_onnx_type(ONNXTensorElementDataType type) {
+    switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: return DataType::Float16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: return DataType::UInt8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: return DataType::Int8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: return DataType::Int32;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: return DataType::Int64;
+    default: return DataType::Float32;
+    }
+}
+
+static GraphOptimizationLevel to_graph_opt_level(int level) {
+    switch (level) {
+    case 0: return GraphOptimizationLevel::ORT_DISABLE_ALL;
+    case 1: return GraphOptimizationLevel::ORT_ENABLE_BASIC;
+    case 2: return GraphOptimizationLevel::ORT_ENABLE_EXTENDED;
+    default: return GraphOptimizationLevel::ORT_ENABLE_ALL;
+    }
+}
+
+void OnnxRuntimeEngine::create_session(const ThreadGrant& grant) {
+    Ort::SessionOptions session_options;
+    session_options.SetIntraOpNumThreads(grant.num_threads);
+    session_options.SetGraphOptimizationLevel(to_graph_opt_level(graph_opt_level_));
+    // ORT pins the pool threads only, the calling thread is the first of the
+    // team: one entry (1-based core ids) per extra thread.
+    if (grant.cpus.size() > 1) {
+        std::string affinities;
+        for (size_t i = 1; i < grant.cpus.size(); i++) {
+            affinities += (i > 1 ? ";" : "") + std::to_string(grant.cpus[i] + 1);
+        }
+        session_options.AddConfigEntry(kOrtSessionOptionsConfigIntraOpThreadAffinities, affinities.c_str());
+    }
+    session_.reset(new Ort::Session(ort_env(), model_path_.c_str(), session_options));
+    native_async_ = grant.num_threads > 1;
+}
+
+bool OnnxRuntimeEngine::load(const ModelFiles& files, const EngineConfig& config) {
+    unload();
+    model_path_ = files.model_path;
+    graph_opt_level_ = config.ort_graph_opt_level;
+    try {
+        create_session(join_thread_budget(config));
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < session_->GetInputCount(); i++) {
+            const Ort::TypeInfo type_info = session_->GetInputTypeInfo(i);
+            const auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
+            input_names_.push_back(session_->GetInputNameAllocated(i, allocator).get());
+            input_shapes_.push_back(tensor_info.GetShape());
+            input_layouts_.push_back(input_shapes_.back().size() == 4 ? Layout::NCHW : Layout::Any);
+            // ONNX carries no quantization on graph inputs: 8-bit ones take raw
+            // pixels, Model skips the spec's mean / norm for them.
+            input_dtypes_.push_back(from_onnx_type(tensor_info.GetElementType()));
+            input_quantization_.push_back(Quantization());
+        }
+        for (size_t i = 0; i < session_->GetOutputCount(); i++) {
+            output_names_.push_back(session_->GetOutputNameAllocated(i, allocator).get());
+        }
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNXRuntime: failed to load " << files.model_path << ": " << e.what() << std::endl;
+        unload();
+        return false;
+    }
+    for (const auto& n : input_names_) input_name_ptrs_.push_back(n.c_str());
+    for (const auto& n : output_names_) output_name_ptrs_.push_back(n.c_str());
+    memory_info_ = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    bindings_.set_capacity(config.shape_cache_size);
+    loaded_ = true;
+    return warmup(config);
+}
+
+bool OnnxRuntimeEngine::infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) {
+    apply_thread_grant(inputs);
+    if (!loaded_ || inputs.size() != input_names_.size()) {
+        std::cerr << "ONNXRuntime: expected " << input_names_.size() << " inputs, got " << inputs.size() << std::endl;
+        return false;
+    }
+    try {
+        std::vector<TensorView> native(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            native[i] = native_input(i, inputs[i]);
+            if (!native[i].data) {
+                return false;
+            }
+        }
+        const ShapeKey key = make_shape_key(native);
+        ShapeBinding* entry = bindings_.find(key);
+        const bool first_run = entry == nullptr;
+        if (first_run) {
+            entry = &bindings_.insert(key, ShapeBinding{Ort::IoBinding(*session_), {}, {}});
+            entry->bound_inputs.assign(native.size(), nullptr);
+            for (const char* name : output_name_ptrs_) {
+                entry->binding.BindOutput(name, memory_info_);
+            }
+        }
+
+        // The caller's buffers are bound as-is, ORT reads them without a copy.
+        for (size_t i = 0; i < native.size(); i++) {
+            const TensorView& v = native[i];
+            if (entry->bound_inputs[i] == v.data) {
+                continue;
+            }
+            entry->bound_inputs[i] = v.data;
+            entry->binding.BindInput(input_name_ptrs_[i], Ort::Value::CreateTensor(memory_info_, v.data,
+                v.storage_bytes(), v.shape, v.ndim, to_onnx_type(v.dtype)));
+        }
+        session_->Run(Ort::RunOptions{nullptr}, entry->binding);
+
+        if (first_run) {
+            entry->outputs = entry->binding.GetOutputValues();
+            entry->binding.ClearBoundOutputs();
+            for (size_t i = 0; i < entry->outputs.size(); i++) {
+                entry->binding.BindOutput(output_name_ptrs_[i], entry->outputs[i]);
+            }
+        }
+
+        outputs.resize(entry->outputs.size());
+        for (size_t i = 0; i < entry->outputs.size(); i++) {
+            auto info = entry->outputs[i].GetTensorTypeAndShapeInfo();
+            std::vector<int64_t> shape = info.GetShape();
+            outputs[i] = TensorView::dense(entry->outputs[i].GetTensorMutableRawData(), shape,
+                from_onnx_type(info.GetElementType()), shape.size() == 4 ? Layout::NCHW : Layout::Any);
+        }
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNXRuntime: Run failed: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// State of one RunAsync call, owned by the completion callback. ORT keeps
+// pointers to the input and output values until then.
+struct OnnxRuntimeEngine::AsyncRun {
+    OnnxRuntimeEngine* engine;
+    AsyncJob job;
+    std::vector<Ort::Value> inputs;
+    std::vector<Ort::Value> outputs;
+};
+
+void OnnxRuntimeEngine::start_job(AsyncJob job) {
+    apply_thread_grant(job.inputs);
+    if (!native_async_) {
+        Engine::start_job(std::move(job));
+        return;
+    }
+    std::unique_ptr<AsyncRun> run(new AsyncRun{this, std::move(job), {}, {}});
+    std::vector<TensorView> native(run->job.inputs.size());
+    bool ok = loaded_ && native.size() == input_names_.size();
+    if (!ok) {
+        std::cerr << "ONNXRuntime: expected " << input_names_.size() << " inputs, got " << native.size() << std::endl;
+    }
+    for (size_t i = 0; ok && i < native.size(); i++) {
+        native[i] = native_input(i, run->job.inputs[i]);
+        ok = native[i].data != nullptr;
+    }
+    try {
+        for (size_t i = 0; ok && i < native.size(); i++) {
+            run->inputs.push_back(Ort::Value::CreateTensor(memory_info_, native[i].data, native[i].storage_bytes(),
+                native[i].shape, native[i].ndim, to_onnx_type(native[i].dtype)));
+        }
+        // ORT allocates this run's outputs and they live in `run` until the
+        // callback. The buffers infer() caches per shape are not reused: an
+        // infer() meanwhile could evict them or write into them mid run.
+        for (size_t i = 0; ok && i < output_name_ptrs_.size(); i++) {
+            run->outputs.emplace_back(nullptr);
+        }
+        if (ok) {
+            session_->RunAsync(Ort::RunOptions{nullptr}, input_name_ptrs_.data(), run->inputs.data(),
+                               run->inputs.size(), output_name_ptrs_.data(), run->outputs.data(),
+                               run->outputs.size(), &OnnxRuntimeEngine::on_run_async, run.get());
+            run.release();
+            return;
+        }
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNXRuntime: RunAsync failed: " << e.what() << std::endl;
+    }
+    run->job.done(false, {});
+    finish_job();
+}
+
+void OnnxRuntimeEngine::on_run_async(void* user_data, OrtValue** values, size_t count, OrtStatusPtr status_ptr) {
+    std::unique_ptr<AsyncRun> run(static_cast<AsyncRun*>(user_data));
+    Ort::Status status(status_ptr);
+    std::vector<TensorView> outputs;
+    bool ok = status.IsOK() && values != nullptr;
+    if (!ok) {
+        std::cerr << "ONNXRuntime: RunAsync failed: " << status.GetErrorMessage() << std::endl;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        // values aliases run->outputs, which now holds every output.
+        auto info = run->outputs[i].GetTensorTypeAndShapeInfo();
+        std::vector<int64_t> shape = info.GetShape();
+        outputs.push_back(TensorView::dense(run->outputs[i].GetTensorMutableRawData(), shape,
+            from_onnx_type(info.GetElementType()), shape.size() == 4 ? Layout::NCHW : Layout::Any));
+    }
+    run->job.done(ok, outputs);
+    OnnxRuntimeEngine* engine = run->engine;
+    run.reset();
+    engine->finish_job();
+}
+
+void OnnxRuntimeEngine::set_threads(const ThreadGrant& grant) {
+    bindings_.clear();
+    try {
+        create_session(grant);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNXRuntime: failed to recreate the session: " << e.what() << std::endl;
+        session_.reset();
+        loaded_ = false;
+    }
+}
+
+void OnnxRuntimeEngine::unload() {
+    wait_idle();
+    bindings_.clear();
+    session_.reset();
+    input_name_ptrs_.clear();
+    output_name_ptrs_.clear();
+    reset_io();
+}
+
+MEI_REGISTER_ENGINE("onnxruntime", OnnxRuntimeEngine, ".onnx", ".ort");
+
+} // namespace mei
@@ -0,0 +1,64 @@
+#ifndef MEI_ENGINES_ONNXRUNTIME_ENGINE_H_
+#define MEI_ENGINES_ONNXRUNTIME_ENGINE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+
+#include "lru_cache.h"
+#include "mei/engine.h"
+
+namespace mei {
+
+class OnnxRuntimeEngine : public Engine {
+public:
+    ~OnnxRuntimeEngine() override { unload(); }
+
+    const char* name() const override { return "onnxruntime"; }
+
+    bool load(const ModelFiles& files, const EngineConfig& config) override;
+    bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) override;
+    void unload() override;
+
+protected:
+    // Session::RunAsync. It runs on the intra-op pool, single threaded
+    // sessions have none and fall back to the shared pool.
+    void start_job(AsyncJob job) override;
+    // Intra-op threads and their affinities are fixed per session, the
+    // session is recreated with the new grant.
+    void set_threads(const ThreadGrant& grant) override;
+
+private:
+    struct AsyncRun;
+    static void on_run_async(void* user_data, OrtValue** values, size_t count, OrtStatusPtr status);
+    // Throws Ort::Exception.
+    void create_session(const ThreadGrant& grant);
+
+    std::string model_path_;
+    int graph_opt_level_ = 99;
+    std::unique_ptr<Ort::Session> session_;
+    bool native_async_ = false;
+    // Raw pointers into input_names_/output_names_, resolved once at load.
+    std::vector<const char*> input_name_ptrs_;
+    std::vector<const char*> output_name_ptrs_;
+    Ort::MemoryInfo memory_info_{nullptr};
+
+    // Binding for one input shape set. After its first run the outputs ORT
+    // allocated are bound back as preallocated outputs, so later runs with the
+    // same shapes write into them instead of allocating and planning again.
+    // The views returned by infer() point into `outputs`. Inputs stay bound
+    // while the caller keeps passing the same buffers, as input_view() does.
+    struct ShapeBinding {
+        Ort::IoBinding binding;
+        std::vector<Ort::Value> outputs;
+        std::vector<const void*> bound_inputs;
+    };
+    // Declared after session_ so the bindings go first.
+    LruCache<ShapeKey, ShapeBinding> bindings_;
+};
+
+} // namespace mei
+
+#endif // MEI_ENGINES_ONNXRUNTIME_ENGINE_H_
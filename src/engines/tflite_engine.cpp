@@ -0,0 +1,209 @@
+#include "engines/tflite_engine.h"
+
+#include <iostream>
+
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/kernels/register.h"
+
+#include "mei/engine_registry.h"
+
+namespace mei {
+
+static std::vector<int64_t> to_shape(const TfLiteIntArray* dims) {
+    return std::vector<int64_t>(dims->data, dims->data + dims->size);
+}
+
+static bool to_dtype(TfLiteType type, DataType& dtype) {
+    switch (type) {
+    case kTfLiteFloat32: dtype = DataType::Float32; return true;
+    case kTfLiteFloat16: dtype = DataType::Float16; return true;
+    case kTfLiteUInt8: dtype = DataType::UInt8; return true;
+    case kTfLiteInt8: dtype = DataType::Int8; return true;
+    case kTfLiteInt32: dtype = DataType::Int32; return true;
+    case kTfLiteInt64: dtype = DataType::Int64; return true;
+    default: return false;
+    }
+}
+
+// View of the tensor's arena memory, no copy. Quantized tensors carry their
+// per-tensor scale / zero point.
+static TensorView tensor_view(const TfLiteTensor* t) {
+    DataType dtype = DataType::Float32;
+    to_dtype(t->type, dtype);
+    std::vector<int64_t> shape = to_shape(t->dims);
+    TensorView view = TensorView::dense(t->data.raw, shape, dtype, shape.size() == 4 ? Layout::NHWC : Layout::Any);
+    if ((dtype == DataType::UInt8 || dtype == DataType::Int8) && t->params.scale > 0.f) {
+        view.quant.scale = t->params.scale;
+        view.quant.zero_point = t->params.zero_point;
+    }
+    return view;
+}
+
+bool TfliteEngine::build(ShapeInterpreter& out) const {
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    tflite::InterpreterBuilder builder(*model_, resolver);
+    builder.SetNumThreads(num_threads_);
+    if (use_xnnpack_) {
+        TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+        options.num_threads = num_threads_;
+        out.xnnpack = std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)>(
+            TfLiteXNNPackDelegateCreate(&options), TfLiteXNNPackDelegateDelete);
+        builder.AddDelegate(out.xnnpack.get());
+    }
+    return builder(&out.interpreter) == kTfLiteOk && out.interpreter;
+}
+
+bool TfliteEngine::load(const ModelFiles& files, const EngineConfig& config) {
+    unload();
+    model_ = tflite::FlatBufferModel::BuildFromFile(files.model_path.c_str());
+    if (!model_) {
+        std::cerr << "TFLite: failed to load model " << files.model_path << std::endl;
+        return false;
+    }
+    num_threads_ = join_thread_budget(config).num_threads;
+    use_xnnpack_ = config.tflite_xnnpack;
+    ShapeInterpreter first;
+    if (!build(first) || first.interpreter->AllocateTensors() != kTfLiteOk) {
+        std::cerr << "TFLite: failed to build interpreter for " << files.model_path << std::endl;
+        unload();
+        return false;
+    }
+
+    ShapeKey key;
+    const tflite::Interpreter* interpreter = first.interpreter.get();
+    for (size_t i = 0; i < interpreter->inputs().size(); i++) {
+        const TfLiteTensor* t = interpreter->input_tensor(i);
+        if (t->type != kTfLiteFloat32 && t->type != kTfLiteUInt8 && t->type != kTfLiteInt8) {
+            std::cerr << "TFLite: only float32 / uint8 / int8 inputs are supported, " << t->name << " is not"
+                      << std::endl;
+            unload();
+            return false;
+        }
+        const TensorView view = tensor_view(t);
+        input_names_.push_back(t->name);
+        input_shapes_.push_back(to_shape(t->dims));
+        input_layouts_.push_back(t->dims->size == 4 ? Layout::NHWC : Layout::Any);
+        input_dtypes_.push_back(view.dtype);
+        input_quantization_.push_back(view.quant);
+        key.push_back(t->dims->size);
+        key.insert(key.end(), t->dims->data, t->dims->data + t->dims->size);
+    }
+    for (size_t i = 0; i < interpreter->outputs().size(); i++) {
+        output_names_.push_back(interpreter->output_tensor(i)->name);
+    }
+    interpreters_.set_capacity(config.shape_cache_size);
+    active_ = &interpreters_.insert(key, std::move(first));
+    active_key_ = key;
+    loaded_ = true;
+    return warmup(config);
+}
+
+bool TfliteEngine::activate(const std::vector<TensorView>& native) {
+    ShapeKey key = make_shape_key(native);
+    if (key == active_key_) {
+        return true;
+    }
+    ShapeInterpreter* cached = interpreters_.find(key);
+    if (!cached) {
+        // A separate interpreter per shape keeps each one's arena planned, so
+        // alternating shapes does not trigger ResizeInputTensor + AllocateTensors.
+        ShapeInterpreter fresh;
+        if (!build(fresh)) {
+            std::cerr << "TFLite: failed to build interpreter" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < native.size(); i++) {
+            std::vector<int> dims(native[i].shape, native[i].shape + native[i].ndim);
+            fresh.interpreter->ResizeInputTensor(fresh.interpreter->inputs()[i], dims);
+        }
+        if (fresh.interpreter->AllocateTensors() != kTfLiteOk) {
+            std::cerr << "TFLite: AllocateTensors failed after resize" << std::endl;
+            return false;
+        }
+        cached = &interpreters_.insert(key, std::move(fresh));
+    }
+    active_ = cached;
+    active_key_ = std::move(key);
+    return true;
+}
+
+TensorView TfliteEngine::bind_input(size_t index, const std::vector<int64_t>& shape) {
+    // Interpreters are keyed by the whole input set, only a lone input selects one.
+    if (input_names_.size() == 1) {
+        const std::vector<TensorView> native(1, TensorView::dense(nullptr, shape, DataType::Float32, input_layouts_[0]));
+        if (activate(native)) {
+            const TensorView view = tensor_view(active_->interpreter->input_tensor(0));
+            if (view.data && view.shape_vector() == shape) {
+                return view;
+            }
+        }
+    }
+    return Engine::bind_input(index, shape);
+}
+
+bool TfliteEngine::infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) {
+    if (!loaded_ || inputs.size() != input_names_.size()) {
+        std::cerr << "TFLite: expected " << input_names_.size() << " inputs, got " << inputs.size() << std::endl;
+        return false;
+    }
+    apply_thread_grant(inputs);
+
+    std::vector<TensorView> native(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        native[i] = native_input(i, inputs[i]);
+        if (!native[i].data) {
+            return false;
+        }
+    }
+    if (!activate(native)) {
+        return false;
+    }
+    tflite::Interpreter* interpreter = active_->interpreter.get();
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const TensorView dst = tensor_view(interpreter->input_tensor(i));
+        if (native[i].data == dst.data) {
+            // Written in place through input_view().
+            continue;
+        }
+        if (!copy_tensor(native[i], dst)) {
+            std::cerr << "TFLite: input " << input_names_[i] << " does not match the model" << std::endl;
+            return false;
+        }
+    }
+
+    if (interpreter->Invoke() != kTfLiteOk) {
+        std::cerr << "TFLite: Invoke failed" << std::endl;
+        return false;
+    }
+
+    outputs.resize(interpreter->outputs().size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        outputs[i] = tensor_view(interpreter->output_tensor(i));
+    }
+    return true;
+}
+
+void TfliteEngine::set_threads(const ThreadGrant& grant) {
+    num_threads_ = grant.num_threads;
+    if (use_xnnpack_) {
+        active_ = nullptr;
+        active_key_.clear();
+        interpreters_.clear();
+        return;
+    }
+    interpreters_.for_each([this](ShapeInterpreter& s) { s.interpreter->SetNumThreads(num_threads_); });
+}
+
+void TfliteEngine::unload() {
+    wait_idle();
+    active_ = nullptr;
+    active_key_.clear();
+    interpreters_.clear();
+    model_.reset();
+    reset_io();
+}
+
+MEI_REGISTER_ENGINE("tflite", TfliteEngine, ".tflite");
+
+} // namespace mei
@@ -0,0 +1,55 @@
+#ifndef MEI_ENGINES_TFLITE_ENGINE_H_
+#define MEI_ENGINES_TFLITE_ENGINE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+#include "lru_cache.h"
+#include "mei/engine.h"
+
+namespace mei {
+
+class TfliteEngine : public Engine {
+public:
+    ~TfliteEngine() override { unload(); }
+
+    const char* name() const override { return "tflite"; }
+
+    bool load(const ModelFiles& files, const EngineConfig& config) override;
+    bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) override;
+    void unload() override;
+
+protected:
+    // The interpreter's input tensor.
+    TensorView bind_input(size_t index, const std::vector<int64_t>& shape) override;
+    // SetNumThreads on every cached interpreter; with XNNPACK the delegate's
+    // pool is fixed, so the interpreters are rebuilt on demand instead.
+    void set_threads(const ThreadGrant& grant) override;
+
+private:
+    // An interpreter allocated for one input shape set. The XNNPACK delegate
+    // must outlive its interpreter, so it is declared first.
+    struct ShapeInterpreter {
+        std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> xnnpack{nullptr, nullptr};
+        std::unique_ptr<tflite::Interpreter> interpreter;
+    };
+
+    bool build(ShapeInterpreter& out) const;
+    // Makes the interpreter for `native`'s shapes active, creating it on a miss.
+    bool activate(const std::vector<TensorView>& native);
+
+    // The interpreters reference the flatbuffer; declared first so it is destroyed last.
+    std::unique_ptr<tflite::FlatBufferModel> model_;
+    int num_threads_ = 1;
+    bool use_xnnpack_ = false;
+    LruCache<ShapeKey, ShapeInterpreter> interpreters_;
+    ShapeInterpreter* active_ = nullptr;
+    ShapeKey active_key_;
+};
+
+} // namespace mei
+
+#endif // MEI_ENGINES_TFLITE_ENGINE_H_
@@ -0,0 +1,190 @@
+#include "engines/tnn_engine.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <tnn/utils/blob_converter.h>
+
+#include "mei/engine_registry.h"
+
+namespace mei {
+
+#if defined(__aarch64__) || defined(__arm__)
+static const TNN_NS::DeviceType kCpuDevice = TNN_NS::DEVICE_ARM;
+#else
+static const TNN_NS::DeviceType kCpuDevice = TNN_NS::DEVICE_X86;
+#endif
+
+// TNN's ModelConfig takes the proto and model contents, not their paths.
+static bool read_file(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+    return true;
+}
+
+bool TnnEngine::load(const ModelFiles& files, const EngineConfig& config) {
+    unload();
+    TNN_NS::ModelConfig model_config;
+    model_config.model_type = TNN_NS::MODEL_TYPE_TNN;
+    model_config.params.resize(2);
+    if (!read_file(files.model_path, model_config.params[0]) || !read_file(files.weights_path, model_config.params[1])) {
+        std::cerr << "TNN: failed to read " << files.model_path << " / " << files.weights_path << std::endl;
+        return false;
+    }
+
+    net_.reset(new TNN_NS::TNN());
+    TNN_NS::Status status = net_->Init(model_config);
+    if (status != TNN_NS::TNN_OK) {
+        std::cerr << "TNN: Init failed: " << status.description() << std::endl;
+        net_.reset();
+        return false;
+    }
+
+    net_config_ = TNN_NS::NetworkConfig();
+    net_config_.device_type = kCpuDevice;
+    num_threads_ = join_thread_budget(config).num_threads;
+    std::shared_ptr<TNN_NS::Instance> instance = net_->CreateInst(net_config_, status);
+    if (!instance || status != TNN_NS::TNN_OK) {
+        std::cerr << "TNN: CreateInst failed: " << status.description() << std::endl;
+        unload();
+        return false;
+    }
+    instance->SetCpuNumThreads(num_threads_);
+
+    ShapeKey key;
+    TNN_NS::BlobMap blobs;
+    instance->GetAllInputBlobs(blobs);
+    for (const auto& kv : blobs) {
+        const TNN_NS::DimsVector& dims = kv.second->GetBlobDesc().dims;
+        input_names_.push_back(kv.first);
+        input_shapes_.push_back(std::vector<int64_t>(dims.begin(), dims.end()));
+        input_layouts_.push_back(dims.size() == 4 ? Layout::NCHW : Layout::Any);
+        input_dtypes_.push_back(DataType::Float32);
+        input_quantization_.push_back(Quantization());
+        key.push_back(static_cast<int64_t>(dims.size()));
+        key.insert(key.end(), dims.begin(), dims.end());
+    }
+    blobs.clear();
+    instance->GetAllOutputBlobs(blobs);
+    for (const auto& kv : blobs) {
+        output_names_.push_back(kv.first);
+    }
+
+    instances_.set_capacity(config.shape_cache_size);
+    ShapeInstance entry;
+    entry.instance = instance;
+    entry.output_mats.resize(output_names_.size());
+    active_ = &instances_.insert(key, std::move(entry));
+    active_key_ = key;
+    loaded_ = true;
+    return warmup(config);
+}
+
+bool TnnEngine::activate(const std::vector<TensorView>& native) {
+    ShapeKey key = make_shape_key(native);
+    if (key == active_key_) {
+        return true;
+    }
+    ShapeInstance* cached = instances_.find(key);
+    if (!cached) {
+        // An instance built for the shape directly, instead of Reshape()ing
+        // the active one back and forth between recurring shapes.
+        TNN_NS::InputShapesMap shapes;
+        for (size_t i = 0; i < native.size(); i++) {
+            shapes[input_names_[i]] = TNN_NS::DimsVector(native[i].shape, native[i].shape + native[i].ndim);
+        }
+        TNN_NS::Status status;
+        ShapeInstance entry;
+        entry.instance = net_->CreateInst(net_config_, status, shapes);
+        if (!entry.instance || status != TNN_NS::TNN_OK) {
+            std::cerr << "TNN: CreateInst failed: " << status.description() << std::endl;
+            return false;
+        }
+        entry.instance->SetCpuNumThreads(num_threads_);
+        entry.output_mats.resize(output_names_.size());
+        cached = &instances_.insert(key, std::move(entry));
+    }
+    active_ = cached;
+    active_key_ = std::move(key);
+    return true;
+}
+
+bool TnnEngine::infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) {
+    if (!loaded_ || inputs.size() != input_names_.size()) {
+        std::cerr << "TNN: expected " << input_names_.size() << " inputs, got " << inputs.size() << std::endl;
+        return false;
+    }
+    apply_thread_grant(inputs);
+
+    std::vector<TensorView> native(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        native[i] = native_input(i, inputs[i]);
+        if (!native[i].data || native[i].dtype != DataType::Float32) {
+            std::cerr << "TNN: input " << input_names_[i] << " must be float32" << std::endl;
+            return false;
+        }
+    }
+    if (!activate(native)) {
+        return false;
+    }
+    TNN_NS::Instance* instance = active_->instance.get();
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        // The Mat wraps the caller's buffer, TNN reads it once while converting into the blob.
+        TNN_NS::DimsVector dims(native[i].shape, native[i].shape + native[i].ndim);
+        auto mat = std::make_shared<TNN_NS::Mat>(kCpuDevice, TNN_NS::NCHW_FLOAT, dims, native[i].data);
+        TNN_NS::Status status = instance->SetInputMat(mat, TNN_NS::MatConvertParam(), input_names_[i]);
+        if (status != TNN_NS::TNN_OK) {
+            std::cerr << "TNN: SetInputMat failed: " << status.description() << std::endl;
+            return false;
+        }
+    }
+
+    TNN_NS::Status status = instance->Forward();
+    if (status != TNN_NS::TNN_OK) {
+        std::cerr << "TNN: Forward failed: " << status.description() << std::endl;
+        return false;
+    }
+
+    outputs.resize(output_names_.size());
+    for (size_t i = 0; i < output_names_.size(); i++) {
+        std::shared_ptr<TNN_NS::Mat>& mat = active_->output_mats[i];
+        status = instance->GetOutputMat(mat, TNN_NS::MatConvertParam(), output_names_[i], kCpuDevice, TNN_NS::NCHW_FLOAT);
+        if (status != TNN_NS::TNN_OK) {
+            std::cerr << "TNN: GetOutputMat failed: " << status.description() << std::endl;
+            return false;
+        }
+        TNN_NS::DimsVector dims = mat->GetDims();
+        std::vector<int64_t> shape(dims.begin(), dims.end());
+        outputs[i] = TensorView::dense(mat->GetData(), shape, DataType::Float32,
+                                       shape.size() == 4 ? Layout::NCHW : Layout::Any);
+    }
+    return true;
+}
+
+void TnnEngine::set_threads(const ThreadGrant& grant) {
+    num_threads_ = grant.num_threads;
+    instances_.for_each([this](ShapeInstance& s) { s.instance->SetCpuNumThreads(num_threads_); });
+}
+
+void TnnEngine::unload() {
+    wait_idle();
+    active_ = nullptr;
+    active_key_.clear();
+    instances_.clear();
+    if (net_) {
+        net_->DeInit();
+    }
+    net_.reset();
+    reset_io();
+}
+
+MEI_REGISTER_ENGINE("tnn", TnnEngine, ".tnnproto");
+
+} // namespace mei
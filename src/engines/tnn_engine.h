@@ -0,0 +1,51 @@
+#ifndef MEI_ENGINES_TNN_ENGINE_H_
+#define MEI_ENGINES_TNN_ENGINE_H_
+
+#include <memory>
+#include <vector>
+
+#include <tnn/core/instance.h>
+#include <tnn/core/mat.h>
+#include <tnn/core/tnn.h>
+
+#include "lru_cache.h"
+#include "mei/engine.h"
+
+namespace mei {
+
+class TnnEngine : public Engine {
+public:
+    ~TnnEngine() override { unload(); }
+
+    const char* name() const override { return "tnn"; }
+
+    bool load(const ModelFiles& files, const EngineConfig& config) override;
+    bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) override;
+    void unload() override;
+
+protected:
+    void set_threads(const ThreadGrant& grant) override;
+
+private:
+    // An instance created for one input shape set.
+    struct ShapeInstance {
+        std::shared_ptr<TNN_NS::Instance> instance;
+        // Host mats from GetOutputMat, the views returned by infer() point into them.
+        std::vector<std::shared_ptr<TNN_NS::Mat>> output_mats;
+    };
+
+    // Makes the instance for `native`'s shapes active, creating it on a miss.
+    bool activate(const std::vector<TensorView>& native);
+
+    std::unique_ptr<TNN_NS::TNN> net_;
+    TNN_NS::NetworkConfig net_config_;
+    int num_threads_ = 1;
+    // Declared after net_ so the instances go before the network.
+    LruCache<ShapeKey, ShapeInstance> instances_;
+    ShapeInstance* active_ = nullptr;
+    ShapeKey active_key_;
+};
+
+} // namespace mei
+
+#endif // MEI_ENGINES_TNN_ENGINE_H_
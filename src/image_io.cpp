@@ -0,0 +1,77 @@
+#include "mei/image_io.h"
+
+#include <fstream>
+
+namespace mei {
+
+static bool read_u16(std::istream& in, int& value) {
+    unsigned char b[2];
+    if (!in.read(reinterpret_cast<char*>(b), 2)) {
+        return false;
+    }
+    value = (b[0] << 8) | b[1];
+    return true;
+}
+
+bool read_jpeg_size(const std::string& path, int& width, int& height) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char soi[2];
+    if (!in.read(reinterpret_cast<char*>(soi), 2) || soi[0] != 0xFF || soi[1] != 0xD8) {
+        return false;
+    }
+    // Walk the marker segments up to the frame header. EXIF / ICC segments
+    // are skipped with a seek, only a few bytes are actually read.
+    while (in) {
+        int c = in.get();
+        if (c != 0xFF) {
+            return false;
+        }
+        int marker;
+        do {
+            marker = in.get();
+        } while (marker == 0xFF);
+        if (marker < 0 || marker == 0xD9 || marker == 0xDA) {
+            // EOI or start of scan: no frame header before the image data.
+            return false;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            // TEM / RSTn carry no length.
+            continue;
+        }
+        int length;
+        if (!read_u16(in, length) || length < 2) {
+            return false;
+        }
+        // SOF0..SOF15, minus DHT (C4), JPG (C8) and DAC (CC).
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            int h, w;
+            if (in.get() < 0 || !read_u16(in, h) || !read_u16(in, w) || w <= 0 || h <= 0) {
+                return false;
+            }
+            width = w;
+            height = h;
+            return true;
+        }
+        in.seekg(length - 2, std::ios::cur);
+    }
+    return false;
+}
+
+int reduced_decode_scale(int width, int height, int min_width, int min_height) {
+    for (int denom = 8; denom > 1; denom /= 2) {
+        if ((width + denom - 1) / denom >= min_width && (height + denom - 1) / denom >= min_height) {
+            return denom;
+        }
+    }
+    return 1;
+}
+
+int decode_scale_for(const std::string& path, const ModelSpec& spec) {
+    int width, height;
+    if (!spec.reduced_decode || !read_jpeg_size(path, width, height)) {
+        return 1;
+    }
+    return reduced_decode_scale(width, height, spec.input_width, spec.input_height);
+}
+
+} // namespace mei
@@ -0,0 +1,88 @@
+#ifndef MEI_AUTOTUNE_H_
+#define MEI_AUTOTUNE_H_
+
+#include <string>
+#include <vector>
+
+#include "mei/engine.h"
+
+namespace mei {
+
+// Fastest measured way to run one model on this host.
+struct TuneEntry {
+    // Profile key, see tune_key().
+    std::string model;
+    // The winning file among the model's formats, and its engine.
+    std::string model_path;
+    std::string engine;
+    EngineConfig config;
+    double avg_ms = 0.0;
+};
+
+// Result of mei_autotune, one line per model:
+//   <model> engine=<name> threads=<n> <knob>=<value>... ms=<avg> model_path=<path>
+// model_path is last and runs to the end of the line, so it may contain spaces.
+class TuneProfile {
+public:
+    // Process wide profile, read once from the file named by $MEI_TUNE_PROFILE
+    // (empty if unset). mei::Model::load(path) consults it.
+    static TuneProfile& instance();
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // nullptr if the model was not tuned.
+    const TuneEntry* find(const std::string& model) const;
+    // Adds or replaces the entry of entry.model.
+    void set(const TuneEntry& entry);
+    const std::vector<TuneEntry>& entries() const { return entries_; }
+
+private:
+    std::vector<TuneEntry> entries_;
+};
+
+// Key a model file is tuned under: its ModelSpec name, otherwise the file name
+// without extension and _float16/_float32 suffix. All formats of one model
+// share the key, e.g. ultraface_detector.onnx and ultraface_detector_float16.tflite.
+std::string tune_key(const std::string& model_path);
+
+// Configurations tried for one engine: 1, 2, 4, ... up to max_threads, times
+// the engine's own knobs (ncnn winograd/sgemm/packing, ORT optimization level,
+// TFLite XNNPACK, MNN precision).
+std::vector<EngineConfig> tune_candidates(const std::string& engine, int max_threads);
+
+// Median time of one forward in ms on a fixed pseudo-random input, after the
+// config's warmup. Dynamic input dimensions are filled from the model's spec.
+// `outputs`, if given, receives every output of the last run as dense float32.
+// Negative on failure.
+double benchmark_model(const std::string& model_path, const EngineConfig& config, int runs,
+                       std::vector<std::vector<float>>* outputs = nullptr);
+
+// True for files named as a lower precision export of a model: a _float16,
+// _fp16, _int8 or _quant suffix before the extension.
+bool lower_precision_file(const std::string& model_path);
+
+struct TuneOptions {
+    // 0: std::thread::hardware_concurrency().
+    int max_threads = 0;
+    int runs = 20;
+    bool verbose = true;
+    // A candidate is kept only if every output stays within max_output_error
+    // of the default config's run of the same file, relative to the largest
+    // magnitude of that output (at least 1). Lossy knobs (MNN low precision,
+    // ncnn winograd on some layers) are dropped when they go past it.
+    float max_output_error = 1e-3f;
+    // Also try lower_precision_file()s and keep every candidate that runs,
+    // whatever its outputs. Off by default: the profile is applied without the
+    // caller knowing, so it must not change results.
+    bool allow_lower_precision = false;
+};
+
+// Benchmarks every file with every candidate config of its engine and returns
+// the fastest that passes the output check. The files are expected to be
+// formats of the same model.
+bool autotune(const std::vector<std::string>& model_paths, const TuneOptions& options, TuneEntry& best);
+
+} // namespace mei
+
+#endif // MEI_AUTOTUNE_H_
@@ -0,0 +1,113 @@
+#ifndef MEI_DETECTION_POSTPROCESS_H_
+#define MEI_DETECTION_POSTPROCESS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mei/image_preprocess.h"
+
+namespace mei {
+
+struct Detection {
+    float x1, y1, x2, y2;
+    float score;
+    int label;
+};
+
+// Boxes of a detection decoder as a structure of arrays: box i is
+// (x1[i], y1[i], x2[i], y2[i]) with score[i] and label[i]. Keep one per
+// thread and reuse it; once the vectors have grown, decoding allocates
+// nothing.
+struct DetectionBuffer {
+    std::vector<float> x1, y1, x2, y2, score;
+    std::vector<int> label;
+    // Decoder scratch: rows that passed the objectness scan.
+    std::vector<int> rows;
+
+    size_t size() const { return score.size(); }
+    void resize(size_t n);
+    void push_back(float x1, float y1, float x2, float y2, float score, int label);
+    // Appends the boxes to `out` as Detection, in buffer order.
+    void append_to(std::vector<Detection>& out) const;
+};
+
+// YOLOv5 output: num_rows rows of (cx, cy, w, h, objectness, num_classes
+// class scores) in network input pixels, e.g. the [1, 25200, 85] "pred"
+// tensor. The objectness column is scanned first (AVX2 gathers where the CPU
+// has them, a branch free compaction elsewhere) into the list of candidate
+// rows; only those get the class argmax and the box transform, so rejected
+// anchors cost one load whatever the class count. A candidate is kept when
+// objectness * best class score >= score_threshold, its box mapped back to
+// the source image with `transform` (e.g. from letterbox_normalize()).
+// Replaces the contents of `out`, in row order.
+void decode_yolov5(const float* data, int64_t num_rows, int num_classes, float score_threshold,
+                   const InputTransform& transform, DetectionBuffer& out);
+
+// Form of the UltraFace "boxes" output.
+enum class UltraFaceBoxes {
+    // x1, y1, x2, y2 normalized to the network input: the box decode is part
+    // of the exported graph, as in the stock models.
+    Corners,
+    // Raw regressions (dcx, dcy, dw, dh) against ultraface_priors(), for
+    // models exported without the in-graph decode.
+    Regression,
+};
+
+// UltraFace prior boxes of a `width` x `height` input, 4 floats per anchor in
+// output order: cx, cy, w, h normalized to the input and clipped to [0, 1].
+// Feature maps of stride 8, 16, 32 and 64 with anchors of {10, 16, 24},
+// {32, 48}, {64, 96} and {128, 192, 256} pixels, as the reference
+// implementation lays them out (4420 anchors at 320x240). Built once per
+// input size and kept for the life of the process; thread safe.
+const std::vector<float>& ultraface_priors(int width, int height);
+
+// UltraFace outputs: `scores` holds num_anchors rows of (background, face),
+// `boxes` num_anchors rows of 4 in `form`. The face column is scanned first
+// (AVX2 gathers where the CPU has them, a branch free compaction elsewhere);
+// only anchors with face score >= score_threshold have their box read, and
+// regressions are decoded against the priors of the input size (variances
+// 0.1 / 0.2, exp only for those anchors), anchors past the priors ignored.
+// Boxes are mapped back to the source image with `transform` (for a plain
+// resize: scale_x = input_width / image width, scale_y likewise), label 1.
+// Replaces the contents of `out`, in anchor order.
+void decode_ultraface(const float* scores, const float* boxes, int64_t num_anchors, UltraFaceBoxes form,
+                      float score_threshold, int input_width, int input_height, const InputTransform& transform,
+                      DetectionBuffer& out);
+
+// How nms() finds the kept boxes that may suppress a candidate. The
+// survivors are the same whichever is used.
+enum class NmsMethod {
+    // Pairwise below a few thousand candidates, Grid from there on.
+    Auto,
+    // Every candidate against every kept box, SIMD blocks of 64.
+    Pairwise,
+    // Kept boxes bucketed in a uniform grid (cells half the median box
+    // size), each candidate tested only against those sharing a cell with
+    // it: near linear for dense scenes of small boxes, e.g. crowds decoded
+    // at a low score threshold. Falls back to Pairwise for a negative
+    // threshold or non finite coordinates.
+    Grid,
+};
+
+// Greedy non maximum suppression: boxes are visited by descending score
+// (equal scores in buffer order) and each is kept unless its IoU with an
+// already kept box is > iou_threshold. Only boxes with the same label
+// suppress each other, unless `agnostic`. `kept` receives the survivors,
+// best first, at most max_detections of them when it is > 0.
+//
+// Sorted boxes are laid out as padded arrays and IoUs computed 64 at a time
+// (AVX2 / NEON where available). Up to a thousand candidates each one is
+// tested against blocks of the kept boxes; beyond that every kept box clears
+// its overlaps from a bitmask of remaining candidates, skipping blocks that
+// are already all suppressed. With max_detections only the best candidates
+// are ranked (nth_element, then a sort of that part), a few times
+// max_detections at first and more only while too few survive, and
+// suppression stops at the last detection needed. Scratch is per thread and
+// reused.
+void nms(const DetectionBuffer& boxes, float iou_threshold, bool agnostic, std::vector<Detection>& kept,
+         int max_detections = 0, NmsMethod method = NmsMethod::Auto);
+
+} // namespace mei
+
+#endif // MEI_DETECTION_POSTPROCESS_H_
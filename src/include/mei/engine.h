@@ -0,0 +1,206 @@
+#ifndef MEI_ENGINE_H_
+#define MEI_ENGINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mei/tensor_view.h"
+#include "mei/thread_budget.h"
+
+namespace mei {
+
+// Files that make up one model. Single-file formats (.mnn, .onnx, .tflite)
+// only use model_path; ncnn (.param + .bin) and TNN (.tnnproto + .tnnmodel)
+// also need weights_path.
+struct ModelFiles {
+    std::string model_path;
+    std::string weights_path;
+};
+
+struct EngineConfig {
+    // Intra-op threads. The examples all run single threaded, keep that default.
+    // This is a request: ThreadBudget may grant fewer while other engines are loaded.
+    int num_threads = 1;
+    // Forward passes run inside load() so the first real request does not pay
+    // for lazy allocation / kernel selection. Engines skip them when an input
+    // shape is dynamic (ncnn always is); Model::load() then runs them at the
+    // spec's input size.
+    int warmup_runs = 1;
+    // Sessions / instances kept per recently seen input shape set (MNN, TNN,
+    // TFLite; ORT keeps its preallocated outputs per shape). Switching back to
+    // a cached shape skips the resize and memory re-planning. Each entry holds
+    // its own activation memory, so the cost is memory, least recently used
+    // first out.
+    int shape_cache_size = 4;
+    // Largest batch Model::predict_batch() packs into one forward when the
+    // model's batch dimension is dynamic.
+    int max_batch = 16;
+
+    // Backend specific knobs, every engine ignores the ones of the others. The
+    // defaults are what the examples use; mei_autotune searches over them.
+    // ncnn::Option use_winograd_convolution / use_sgemm_convolution / use_packing_layout.
+    bool ncnn_winograd = true;
+    bool ncnn_sgemm = true;
+    bool ncnn_packing = true;
+    // ONNXRuntime GraphOptimizationLevel: 0 disabled, 1 basic, 2 extended, 99 all.
+    int ort_graph_opt_level = 99;
+    // Run TFLite graphs through the XNNPACK delegate.
+    bool tflite_xnnpack = false;
+    // MNN BackendConfig::PrecisionMode: 0 normal, 1 high, 2 low.
+    int mnn_precision = 0;
+};
+
+// Completion of an asynchronous inference. The output views are only valid
+// for the duration of the call.
+using InferCallback = std::function<void(bool ok, const std::vector<TensorView>& outputs)>;
+
+// A resident model instance. load() pays the model parsing, session creation
+// and warmup cost once; infer() can then be called any number of times until
+// unload(). An Engine is not thread safe, use one instance per thread.
+//
+// submit() is the exception: it may be called from any thread, jobs on one
+// engine run one at a time in submission order, off the calling thread. Do not
+// mix it with infer() while jobs are pending.
+class Engine {
+public:
+    virtual ~Engine() = default;
+
+    virtual const char* name() const = 0;
+
+    virtual bool load(const ModelFiles& files, const EngineConfig& config) = 0;
+    // Inputs are read in place where the engine allows it. A view whose layout
+    // differs from input_layouts()[i] is converted once; Layout::Any is taken
+    // as already native. The returned views point into engine owned memory and
+    // stay valid until the next infer() or unload().
+    virtual bool infer(const std::vector<TensorView>& inputs, std::vector<TensorView>& outputs) = 0;
+    virtual void unload() = 0;
+
+    // Engine owned memory for input `index` with `shape` (in the order of
+    // input_layouts()[index]), of type input_dtype(index) and carrying its
+    // input_quant(index). Writing the input there and passing the view to
+    // infer() skips the copy into the backend: MNN and TFLite hand
+    // out the session / interpreter input tensor (single input CPU models),
+    // ncnn the input Mat (channel pitch in strides[1]), ORT a buffer that
+    // stays bound to the session, TNN the Mat it converts from. The view is
+    // valid until the next input_view() or infer() with other shapes, or
+    // unload(). Call it from the thread that runs infer(); empty on error.
+    TensorView input_view(size_t index, const std::vector<int64_t>& shape);
+
+    // Queues an inference and returns immediately; `done` runs on an engine
+    // or pool thread. The input buffers must stay valid until then. ORT uses
+    // its native async run, the other engines run infer() on
+    // ThreadPool::shared().
+    void submit(const std::vector<TensorView>& inputs, InferCallback done);
+    // Same, copying the outputs (float32 only) into `outputs`, which must
+    // outlive the future.
+    std::future<bool> submit(const std::vector<TensorView>& inputs, std::vector<Tensor>& outputs);
+    // Blocks until every submitted job has completed.
+    void wait_idle();
+
+    bool loaded() const { return loaded_; }
+
+    const std::vector<std::string>& input_names() const { return input_names_; }
+    const std::vector<std::string>& output_names() const { return output_names_; }
+    // Shapes as declared by the model, -1 for dynamic dimensions.
+    const std::vector<std::vector<int64_t>>& input_shapes() const { return input_shapes_; }
+    const std::vector<Layout>& input_layouts() const { return input_layouts_; }
+    // Element type infer() takes for input `index`: float32, except on TFLite
+    // and ONNXRuntime where a model may declare UInt8 / Int8 inputs (MNN, ncnn
+    // and TNN quantize internally and always take float32). Quantized TFLite
+    // inputs carry their scale / zero point, the others the identity. Engines
+    // that do not list their input types are taken as float32.
+    DataType input_dtype(size_t index) const;
+    Quantization input_quant(size_t index) const;
+    // Threads ThreadBudget currently grants this engine, 1 until load().
+    // Model sizes its preprocessing by it, so the two stay within the budget.
+    int granted_threads() const { return granted_threads_.load(std::memory_order_relaxed); }
+
+protected:
+    // Runs config.warmup_runs forwards on zero filled inputs of the declared shapes.
+    bool warmup(const EngineConfig& config);
+    void reset_io();
+    // Returns `in` itself when it is an input_view() or dense and already in
+    // the native layout of input `index`, otherwise a converted copy kept in a
+    // per-input staging buffer.
+    TensorView native_input(size_t index, const TensorView& in);
+    // Backs input_view(). The default is a dense buffer of the native layout
+    // owned by the Engine base.
+    virtual TensorView bind_input(size_t index, const std::vector<int64_t>& shape);
+    // True if `in` points at the memory input_view() handed out for `index`.
+    bool is_input_view(size_t index, const TensorView& in) const;
+
+    struct AsyncJob {
+        std::vector<TensorView> inputs;
+        InferCallback done;
+    };
+    // Starts the next job. Overrides must eventually call job.done, then
+    // finish_job(), from whatever thread completes the run. The default runs
+    // infer() on ThreadPool::shared().
+    virtual void start_job(AsyncJob job);
+    // Starts the following queued job, or marks the engine idle.
+    void finish_job();
+
+    // Joins ThreadBudget with config.num_threads as the request; load()
+    // creates the backend with the returned grant. reset_io() leaves.
+    ThreadGrant join_thread_budget(const EngineConfig& config);
+    // Called at the top of infer(): hands a grant the budget changed since
+    // the last call to set_threads(), on the thread that runs the engine.
+    // Skipped while `inputs` sit in input_view() memory, which a rebuild
+    // would free; input_view() applies it instead.
+    void apply_thread_grant(const std::vector<TensorView>& inputs);
+    // Moves the backend to the grant. Knobs that are fixed once a session
+    // exists are applied by rebuilding it.
+    virtual void set_threads(const ThreadGrant& /*grant*/) {}
+
+    bool loaded_ = false;
+    std::vector<std::string> input_names_;
+    std::vector<std::string> output_names_;
+    std::vector<std::vector<int64_t>> input_shapes_;
+    std::vector<Layout> input_layouts_;
+    std::vector<DataType> input_dtypes_;
+    std::vector<Quantization> input_quantization_;
+
+private:
+    friend class ThreadBudget;
+    // Called by ThreadBudget from whatever thread rebalanced.
+    void post_thread_grant(const ThreadGrant& grant);
+
+    std::vector<std::vector<uint8_t>> staging_;
+    // What input_view() handed out, and the default bind_input() buffers.
+    std::vector<TensorView> input_views_;
+    std::vector<std::vector<uint8_t>> input_buffers_;
+
+    bool budgeted_ = false;
+    std::mutex grant_mutex_;
+    ThreadGrant pending_grant_;
+    std::atomic<bool> grant_pending_{false};
+    std::atomic<int> granted_threads_{1};
+
+    std::mutex async_mutex_;
+    std::condition_variable async_idle_;
+    std::deque<AsyncJob> async_queue_;
+    bool async_busy_ = false;
+};
+
+// Creates an engine by backend name: "mnn", "ncnn", "onnxruntime", "tflite", "tnn".
+// Returns nullptr if the backend is unknown or was disabled at build time.
+std::unique_ptr<Engine> create_engine(const std::string& name);
+// Same, but picks the backend from the model file extension
+// (.mnn, .param/.bin, .onnx, .tflite, .tnnproto).
+std::unique_ptr<Engine> create_engine_for_model(const std::string& model_path);
+
+// Derives the weights file of two-file formats: foo.param -> foo.bin,
+// foo.tnnproto -> foo.tnnmodel. Single-file formats leave weights_path empty.
+ModelFiles model_files_for(const std::string& model_path);
+
+} // namespace mei
+
+#endif // MEI_ENGINE_H_
@@ -0,0 +1,63 @@
+#ifndef MEI_ENGINE_REGISTRY_H_
+#define MEI_ENGINE_REGISTRY_H_
+
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mei/engine.h"
+
+namespace mei {
+
+using EngineFactory = std::unique_ptr<Engine> (*)();
+
+// Link-time registry of the backends compiled into the library. Every engine
+// translation unit registers itself through MEI_REGISTER_ENGINE; a backend
+// disabled with MEI_ENABLE_<BACKEND>=OFF is not compiled, so it contributes
+// neither code nor a static initializer.
+class EngineRegistry {
+public:
+    static constexpr int kMaxEngines = 8;
+    static constexpr int kMaxExtensions = 4;
+
+    static EngineRegistry& instance();
+
+    void add(const char* name, EngineFactory factory, std::initializer_list<const char*> extensions);
+
+    // nullptr if no backend with that name is registered.
+    std::unique_ptr<Engine> create(const std::string& name) const;
+    // Picks the backend from the model file extension (".onnx", ".param", ...).
+    std::unique_ptr<Engine> create_for_model(const std::string& model_path) const;
+    // Name of the backend handling this model file, nullptr if none.
+    const char* engine_for_model(const std::string& model_path) const;
+
+    std::vector<std::string> names() const;
+
+private:
+    struct Entry {
+        const char* name;
+        EngineFactory factory;
+        const char* extensions[kMaxExtensions];
+    };
+
+    // Plain array, filled during static initialization without touching the heap.
+    Entry entries_[kMaxEngines];
+    int count_ = 0;
+};
+
+struct EngineRegistrar {
+    EngineRegistrar(const char* name, EngineFactory factory, std::initializer_list<const char*> extensions) {
+        EngineRegistry::instance().add(name, factory, extensions);
+    }
+};
+
+} // namespace mei
+
+// MEI_REGISTER_ENGINE("mnn", MnnEngine, ".mnn") at namespace scope in the engine's .cpp.
+#define MEI_REGISTER_ENGINE(name, cls, ...)                                              \
+    static ::mei::EngineRegistrar mei_engine_registrar_##cls(                            \
+        name, []() -> std::unique_ptr<::mei::Engine> { return std::unique_ptr<::mei::Engine>(new cls()); }, \
+        {__VA_ARGS__})
+
+#endif // MEI_ENGINE_REGISTRY_H_
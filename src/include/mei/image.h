@@ -0,0 +1,102 @@
+#ifndef MEI_IMAGE_H_
+#define MEI_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mei {
+
+// Channel order of 8-bit interleaved pixels. Also used by ModelSpec to
+// describe the order the network was trained with.
+enum class PixelFormat {
+    BGR,
+    RGB,
+    Gray,
+};
+
+constexpr int kPixelFormatCount = 3;
+
+inline int pixel_channels(PixelFormat format) {
+    return format == PixelFormat::Gray ? 1 : 3;
+}
+
+// Non-owning view of an 8-bit interleaved image, e.g. the data of a cv::Mat
+// (CV_8UC3 is BGR, CV_8UC1 is Gray). The library itself does not depend on
+// OpenCV.
+struct ImageView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    // Bytes between the starts of two rows.
+    int stride = 0;
+    PixelFormat format = PixelFormat::BGR;
+
+    static ImageView packed(const uint8_t* data, int width, int height, PixelFormat format) {
+        ImageView v;
+        v.data = data;
+        v.width = width;
+        v.height = height;
+        v.stride = width * pixel_channels(format);
+        v.format = format;
+        return v;
+    }
+
+    bool empty() const { return data == nullptr || width <= 0 || height <= 0; }
+};
+
+// Non-owning view of an 8-bit 4:2:0 frame as video decoders and V4L2 cameras
+// hand them out: a full resolution Y plane and U / V at half resolution in
+// both directions. uv_step is the distance between two samples of one chroma
+// channel: 2 for the interleaved plane of NV12 / NV21, 1 for I420's separate
+// planes. BT.601 limited range, like OpenCV's COLOR_YUV2BGR_NV12.
+struct YuvImageView {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    int width = 0;
+    int height = 0;
+    // Bytes between the starts of two rows of the Y / chroma planes.
+    int y_stride = 0;
+    int uv_stride = 0;
+    int uv_step = 1;
+
+    // `uv` is the interleaved chroma plane, U first.
+    static YuvImageView nv12(const uint8_t* y, const uint8_t* uv, int width, int height, int y_stride,
+                             int uv_stride) {
+        return planes(y, uv, uv + 1, width, height, y_stride, uv_stride, 2);
+    }
+    // Same, V first.
+    static YuvImageView nv21(const uint8_t* y, const uint8_t* vu, int width, int height, int y_stride,
+                             int uv_stride) {
+        return planes(y, vu + 1, vu, width, height, y_stride, uv_stride, 2);
+    }
+    static YuvImageView i420(const uint8_t* y, const uint8_t* u, const uint8_t* v, int width, int height,
+                             int y_stride, int uv_stride) {
+        return planes(y, u, v, width, height, y_stride, uv_stride, 1);
+    }
+    // A packed NV12 buffer: the Y plane directly followed by the UV plane.
+    static YuvImageView nv12(const uint8_t* data, int width, int height) {
+        return nv12(data, data + static_cast<size_t>(width) * height, width, height, width, (width + 1) / 2 * 2);
+    }
+
+    bool empty() const { return y == nullptr || u == nullptr || v == nullptr || width <= 0 || height <= 0; }
+
+private:
+    static YuvImageView planes(const uint8_t* y, const uint8_t* u, const uint8_t* v, int width, int height,
+                               int y_stride, int uv_stride, int uv_step) {
+        YuvImageView view;
+        view.y = y;
+        view.u = u;
+        view.v = v;
+        view.width = width;
+        view.height = height;
+        view.y_stride = y_stride;
+        view.uv_stride = uv_stride;
+        view.uv_step = uv_step;
+        return view;
+    }
+};
+
+} // namespace mei
+
+#endif // MEI_IMAGE_H_
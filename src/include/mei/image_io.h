@@ -0,0 +1,24 @@
+#ifndef MEI_IMAGE_IO_H_
+#define MEI_IMAGE_IO_H_
+
+#include <string>
+
+#include "mei/model_spec.h"
+
+namespace mei {
+
+// Image size from the frame header (SOFn) of a JPEG file, read without
+// decoding anything. False if the file cannot be read or is not a JPEG.
+bool read_jpeg_size(const std::string& path, int& width, int& height);
+
+// Largest libjpeg IDCT scale denominator (8, 4 or 2, else 1) whose output,
+// ceil(size / denominator) on each axis, still covers min_width x min_height.
+int reduced_decode_scale(int width, int height, int min_width, int min_height);
+
+// Denominator to decode `path` with before it is resized to spec's input: 1
+// unless spec.reduced_decode is set and the file is a JPEG large enough.
+int decode_scale_for(const std::string& path, const ModelSpec& spec);
+
+} // namespace mei
+
+#endif // MEI_IMAGE_IO_H_
@@ -0,0 +1,46 @@
+#ifndef MEI_IMAGE_IO_OPENCV_H_
+#define MEI_IMAGE_IO_OPENCV_H_
+
+#include <string>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "mei/image_io.h"
+
+namespace mei {
+
+// cv::imread with libjpeg IDCT scaling: a JPEG is decoded at the smallest of
+// 1/8, 1/4, 1/2 and full size that still covers min_width x min_height, the
+// final resize to the input is left to the preprocessing. Other formats are
+// read at full size. `flags` is cv::IMREAD_COLOR or cv::IMREAD_GRAYSCALE.
+//
+// Header only so the library itself does not link OpenCV; include it from
+// code that already does (examples, tools).
+inline cv::Mat imread_for_input(const std::string& path, int min_width, int min_height,
+                                int flags = cv::IMREAD_COLOR) {
+    int width = 0;
+    int height = 0;
+    const int scale = read_jpeg_size(path, width, height) ? reduced_decode_scale(width, height, min_width, min_height)
+                                                          : 1;
+    const bool gray = flags == cv::IMREAD_GRAYSCALE;
+    switch (scale) {
+    case 2: return cv::imread(path, gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2);
+    case 4: return cv::imread(path, gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4);
+    case 8: return cv::imread(path, gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8);
+    default: return cv::imread(path, flags);
+    }
+}
+
+// Reads `path` for a model of `spec`: grayscale for Gray inputs, reduced
+// when spec.reduced_decode allows it.
+inline cv::Mat imread_for_spec(const std::string& path, const ModelSpec& spec) {
+    const int flags = spec.color == PixelFormat::Gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    if (!spec.reduced_decode) {
+        return cv::imread(path, flags);
+    }
+    return imread_for_input(path, spec.input_width, spec.input_height, flags);
+}
+
+} // namespace mei
+
+#endif // MEI_IMAGE_IO_OPENCV_H_
@@ -0,0 +1,77 @@
+#ifndef MEI_IMAGE_PREPROCESS_H_
+#define MEI_IMAGE_PREPROCESS_H_
+
+#include "mei/image.h"
+#include "mei/tensor_view.h"
+
+namespace mei {
+
+// Maps network input coordinates back to the source image:
+// src_x = (x - dx) / scale_x, src_y = (y - dy) / scale_y.
+struct InputTransform {
+    float scale_x = 1.f;
+    float scale_y = 1.f;
+    float dx = 0.f;
+    float dy = 0.f;
+};
+
+// Resize, channel reorder, normalize and HWC -> CHW in a single pass over the
+// source: every output row is bilinearly resampled (cv::resize INTER_LINEAR
+// sampling, 8-bit intermediate like cv::resize produces, matching it to within
+// 1 LSB rather than bit for bit) into a small row buffer and converted to
+// float straight away, with AVX2 / NEON where the CPU has them.
+//
+// dst receives dst_format channels, value = (pixel - mean[c]) * norm[c] with
+// mean / norm in dst_format order, as planes (Layout::NCHW) or interleaved
+// (Layout::NHWC). It holds dst_width * dst_height * pixel_channels(dst_format)
+// floats.
+void resize_normalize(const ImageView& src, int dst_width, int dst_height, PixelFormat dst_format,
+                      const float* mean, const float* norm, Layout layout, float* dst);
+
+// Same, writing into `dst` wherever it lives (e.g. Engine::input_view()): a
+// 4-D view, NCHW (Layout::Any is taken as NCHW) or NHWC, whose shape gives
+// the output size. Row and channel pitches are taken from its strides. A
+// UInt8 / Int8 view (quantized model input) receives
+// round(value / dst.quant.scale) + dst.quant.zero_point, saturated, straight
+// from a per-channel table; no float is written. Returns false if `src` is
+// empty or `dst` is not such a view with pixel_channels(dst_format) channels.
+bool resize_normalize(const ImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                      const TensorView& dst);
+
+// Letterbox into a dst_width x dst_height input: the image is scaled by
+// r = min(dst_width / width, dst_height / height), keeping its aspect ratio,
+// and centered; the border is pad_value (before normalization), as in the
+// yolov5 letterbox. Resampling, channel reorder and normalization happen in
+// the same single pass as resize_normalize(), and only the border around the
+// image is filled. Returns the transform mapping detections back.
+InputTransform letterbox_normalize(const ImageView& src, int dst_width, int dst_height, PixelFormat dst_format,
+                                   const float* mean, const float* norm, float pad_value, Layout layout, float* dst);
+
+// Same, into a 4-D view as taken by resize_normalize() (float32 or
+// quantized). Returns false if `src` is empty or `dst` is not such a view.
+bool letterbox_normalize(const ImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                         float pad_value, const TensorView& dst, InputTransform& transform);
+
+// Crop, resize and normalize in one pass: the width x height rectangle at
+// (x, y) of `src` is resampled to the size of `dst` (a view as taken by
+// resize_normalize()). The rectangle may reach past the image; pixels outside
+// are 0, exactly as if the image had been copied into a zero canvas and
+// resized, but without building that canvas (FSA-Net's 30% margin is
+// nw = 1.3 * w, x = -(nw - w) / 2, width = nw). `transform` maps dst
+// coordinates back to `src`. Returns false if `src` or the rectangle is empty
+// or `dst` is not such a view.
+bool crop_normalize(const ImageView& src, int x, int y, int width, int height, PixelFormat dst_format,
+                    const float* mean, const float* norm, const TensorView& dst, InputTransform& transform);
+
+// 4:2:0 frames (NV12 / NV21 / I420) straight from a decoder or camera: the
+// Y and chroma planes are resampled to the output size, converted to color
+// there and normalized in the same pass, so no full resolution BGR frame is
+// formed. Otherwise as the ImageView overloads above.
+bool resize_normalize(const YuvImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                      const TensorView& dst);
+bool letterbox_normalize(const YuvImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                         float pad_value, const TensorView& dst, InputTransform& transform);
+
+} // namespace mei
+
+#endif // MEI_IMAGE_PREPROCESS_H_
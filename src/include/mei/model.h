@@ -0,0 +1,130 @@
+#ifndef MEI_MODEL_H_
+#define MEI_MODEL_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mei/detection_postprocess.h"
+#include "mei/engine.h"
+#include "mei/image.h"
+#include "mei/image_preprocess.h"
+#include "mei/model_spec.h"
+
+namespace mei {
+
+struct Prediction {
+    // Yolov5 / UltraFace, in source image pixels, sorted by score.
+    std::vector<Detection> detections;
+    // Raw / Softmax decoders: output 0, flattened.
+    std::vector<float> values;
+};
+
+// Completion of Model::submit(), run on the engine's worker thread.
+using PredictCallback = std::function<void(bool ok, Prediction& result)>;
+
+// An engine plus its ModelSpec. Blob names are resolved to indices and the
+// preprocessing / decoding kernels are picked once in load(), predict() only
+// indexes into what was resolved there. Not thread safe, like Engine.
+class Model {
+public:
+    ~Model() { unload(); }
+
+    // Looks the spec up from the model file name. If the TuneProfile has an
+    // entry for the spec, its file and config are used instead of the given ones.
+    bool load(const std::string& model_path, const EngineConfig& config = EngineConfig());
+    bool load(const ModelSpec& spec, const std::string& model_path, const EngineConfig& config = EngineConfig());
+    bool predict(const ImageView& image, Prediction& result);
+    // NV12 / NV21 / I420 frames, without a BGR copy of the frame for Stretch
+    // and Letterbox specs.
+    bool predict(const YuvImageView& image, Prediction& result);
+    // Preprocesses `image` on the calling thread (it may be released on
+    // return), then queues inference and decoding through Engine::submit().
+    // The caller can decode / preprocess the next request meanwhile. Calls
+    // must come from one thread at a time; do not mix with predict() while
+    // requests are pending.
+    void submit(const ImageView& image, PredictCallback done);
+    // Runs many images in as few forwards as possible: models with a dynamic
+    // batch dimension take up to EngineConfig::max_batch images per forward,
+    // models with a fixed batch of B take B at a time (batch 1: one by one).
+    // results[i] belongs to images[i].
+    bool predict_batch(const std::vector<ImageView>& images, std::vector<Prediction>& results);
+    // Blocks until every submitted request has completed.
+    void wait_idle();
+    void unload();
+
+    const ModelSpec* spec() const { return spec_; }
+    Engine* engine() const { return engine_.get(); }
+
+    // Per channel normalization constants, in network channel order. Source
+    // pixels are 8-bit, so every channel has 256 possible outputs:
+    // lut[c][v] = (v - mean[c]) * norm[c], the same float the arithmetic
+    // kernels compute, and qlut[c][v] that value quantized for a UInt8 / Int8
+    // input (`dtype`, `quant`), stored as the tensor's byte.
+    struct NormalizeParams {
+        DataType dtype;
+        Quantization quant;
+        float mean[3];
+        float norm[3];
+        float lut[3][256];
+        uint8_t qlut[3][256];
+    };
+
+    // Kernel signatures, the instances live in preprocess.cpp / postprocess.cpp.
+    // NormalizeFn converts one row of `width` pixels into elements of
+    // NormalizeParams::dtype; planar kernels write channel c at dst + c * plane
+    // (in elements).
+    using NormalizeFn = void (*)(const uint8_t* src, int width, const NormalizeParams& params, void* dst,
+                                 size_t plane);
+    using DecodeFn = void (*)(const ModelSpec& spec, const std::vector<TensorView>& outputs,
+                              const InputTransform& transform, Prediction& result);
+
+private:
+    // Writes the input tensor for `image` into `dst`, a view shaped like inputs_[0].
+    bool preprocess(const ImageView& image, const TensorView& dst, InputTransform& transform);
+    bool preprocess(const YuvImageView& image, const TensorView& dst, InputTransform& transform);
+    template <typename Image>
+    bool predict_image(const Image& image, Prediction& result);
+    bool decode(const std::vector<TensorView>& outputs, const InputTransform& transform, Prediction& result);
+
+    const ModelSpec* spec_ = nullptr;
+    std::unique_ptr<Engine> engine_;
+    // Spec output order -> engine output index.
+    std::vector<size_t> output_indexes_;
+    // One normalize kernel per source PixelFormat, for the engine input layout.
+    NormalizeFn normalize_[kPixelFormatCount] = {};
+    NormalizeParams normalize_params_;
+    DecodeFn decode_ = nullptr;
+    Layout input_layout_ = Layout::NCHW;
+
+    // BGR copy of a 4:2:0 frame, only for ResizeMode::Pad.
+    std::vector<uint8_t> frame_;
+    // Own input buffer (bytes of the input's dtype), for engines without
+    // input_view() memory and for submit() / predict_batch(). predict()
+    // writes into engine_inputs_.
+    std::vector<uint8_t> input_data_;
+    std::vector<TensorView> inputs_;
+    std::vector<TensorView> engine_inputs_;
+    std::vector<TensorView> outputs_;
+    std::vector<TensorView> decoder_outputs_;
+    std::vector<std::vector<uint8_t>> output_copies_;
+
+    // Images per forward in predict_batch(), and whether that count may shrink.
+    int64_t batch_limit_ = 1;
+    bool dynamic_batch_ = false;
+    std::vector<uint8_t> batch_data_;
+    std::vector<InputTransform> batch_transforms_;
+    std::vector<TensorView> batch_inputs_;
+    std::vector<TensorView> batch_outputs_;
+    std::vector<TensorView> item_outputs_;
+
+    // Input buffers of submitted requests, recycled once their inference is done.
+    std::mutex free_inputs_mutex_;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> free_inputs_;
+};
+
+} // namespace mei
+
+#endif // MEI_MODEL_H_
@@ -0,0 +1,112 @@
+#ifndef MEI_MODEL_POOL_H_
+#define MEI_MODEL_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "mei/model.h"
+
+namespace mei {
+
+// Keeps as many models resident as fit in a memory budget.
+//
+// Models are registered up front and loaded on first use. A model's footprint
+// (weights plus the arenas its engine allocates during load and warmup) is
+// measured as the resident set growth over its first load, and at least its
+// file size. That one load waits for running predictions and loads to finish
+// and holds new ones back, so the growth is its own; reloads reuse the
+// footprint and do not stop traffic. A model that turns out larger than its
+// estimate and still does not fit is unloaded again. When a load would exceed
+// the budget, the least recently used idle models are unloaded first. Evicted
+// models are reloaded on a background thread as soon as they fit again, so
+// they are warm when traffic comes back.
+//
+// predict() may be called from several threads; calls on the same model are
+// serialized, calls on different models run concurrently.
+class ModelPool {
+public:
+    explicit ModelPool(size_t budget_bytes, const EngineConfig& config = EngineConfig());
+    ~ModelPool();
+
+    ModelPool(const ModelPool&) = delete;
+    ModelPool& operator=(const ModelPool&) = delete;
+
+    // Registers a model under `key`, the spec is found from the file name.
+    bool add(const std::string& key, const std::string& model_path);
+    bool add(const std::string& key, const ModelSpec& spec, const std::string& model_path);
+
+    // Loads the model if needed (evicting others to make room) and runs it.
+    bool predict(const std::string& key, const ImageView& image, Prediction& result);
+    // Queues a background load, e.g. ahead of expected traffic.
+    void prefetch(const std::string& key);
+
+    // Unloads the model for good: it is not reloaded in the background, and the
+    // freed room goes to evicted models.
+    void unload(const std::string& key);
+
+    // Lowering the budget evicts immediately, raising it reloads evicted models.
+    void set_budget(size_t budget_bytes);
+    size_t budget_bytes() const;
+    // Sum of the footprints of the resident models.
+    size_t resident_bytes() const;
+    bool resident(const std::string& key) const;
+    // Last measured footprint, 0 if never loaded.
+    size_t footprint(const std::string& key) const;
+
+private:
+    struct Entry {
+        std::string key;
+        const ModelSpec* spec = nullptr;
+        std::string model_path;
+        std::unique_ptr<Model> model;
+        size_t footprint = 0;
+        uint64_t last_used = 0;
+        int in_use = 0;
+        bool loading = false;
+        bool evicted = false;
+        // Model is not thread safe, one predict() at a time.
+        std::mutex run_mutex;
+    };
+
+    Entry* find(const std::string& key) const;
+    // Called with lock held; drops and reacquires it around the actual load.
+    bool load_locked(Entry* entry, std::unique_lock<std::mutex>& lock, bool allow_evict);
+    // Unloads LRU idle models other than `keep` until `needed` more bytes fit.
+    bool make_room_locked(size_t needed, const Entry* keep);
+    void schedule_reloads_locked();
+    void worker_loop();
+
+    const EngineConfig config_;
+    size_t budget_;
+    size_t resident_ = 0;
+    uint64_t clock_ = 0;
+    std::map<std::string, std::unique_ptr<Entry>> entries_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+    // A first load is measuring its RSS delta: no other load, predict() or
+    // unload may run. running_ counts the predict() calls in flight on any
+    // model, loads_ the loads.
+    bool measuring_ = false;
+    int running_ = 0;
+    int loads_ = 0;
+
+    // Keys to load in the background, and whether that may evict other models
+    // (prefetch) or must fit in the free room (reload after eviction).
+    std::deque<std::pair<std::string, bool>> reload_queue_;
+    std::condition_variable queue_cv_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+} // namespace mei
+
+#endif // MEI_MODEL_POOL_H_
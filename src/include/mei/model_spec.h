@@ -0,0 +1,89 @@
+#ifndef MEI_MODEL_SPEC_H_
+#define MEI_MODEL_SPEC_H_
+
+#include <cstddef>
+#include <string>
+
+#include "mei/image.h"
+
+namespace mei {
+
+// How the source image is mapped onto the network input.
+enum class ResizeMode {
+    // Plain resize to the input size, aspect ratio is not kept.
+    Stretch,
+    // Aspect preserving resize, centered, border filled with resize_param.
+    Letterbox,
+    // Image is first padded by resize_param * size on every side (split
+    // evenly, zero filled), then stretched.
+    Pad,
+};
+
+// Post-processing applied to the raw outputs.
+enum class DecoderKind {
+    // Output 0 copied as is (regressions: age, head pose, landmarks).
+    Raw,
+    // Softmax over output 0 (classifiers).
+    Softmax,
+    // [1, N, 5 + classes] cx,cy,w,h,objectness,class scores, then NMS.
+    Yolov5,
+    // "scores" [1, N, 2] and "boxes" [1, N, 4] in normalized corners, then NMS.
+    UltraFace,
+    // As UltraFace, for models exported without the in-graph box decode:
+    // "boxes" holds raw regressions against ultraface_priors().
+    UltraFaceRegression,
+};
+
+// Everything an example used to hardcode about a model. The input layout is
+// not part of the spec, it is the engine's native one (NCHW, or NHWC for
+// TFLite) so preprocessing can write it directly.
+struct ModelSpec {
+    static constexpr int kMaxOutputs = 4;
+
+    const char* name;
+    int input_width;
+    int input_height;
+    // Channel order the network expects, Gray for single channel inputs.
+    PixelFormat color;
+    // Per channel, in network order: value = (pixel - mean) * norm.
+    float mean[3];
+    float norm[3];
+    ResizeMode resize;
+    // Letterbox fill value, or padding ratio for ResizeMode::Pad.
+    float resize_param;
+    DecoderKind decoder;
+    // Yolov5 only.
+    int num_classes;
+    float score_threshold;
+    float iou_threshold;
+    // Detectors: best detections kept per image, 0 for all of them.
+    int max_detections;
+    // Detectors: NMS across classes (a box suppresses overlapping boxes of
+    // any label) instead of within each class.
+    bool agnostic;
+    // Output blobs in the order the decoder reads them. Names differ between
+    // exported formats, so a name the model does not have falls back to the
+    // declaration order. nullptr ends the list; no names means output 0. All
+    // models take a single image input, which needs no name.
+    const char* output_names[kMaxOutputs];
+    // Source JPEGs may be decoded at 1/2, 1/4 or 1/8 scale (libjpeg IDCT
+    // scaling) as long as the result still covers the input size, see
+    // image_io.h. Set for the small input models, where decoding a camera
+    // frame at full size costs more than the inference.
+    bool reduced_decode;
+
+    int input_channels() const { return pixel_channels(color); }
+};
+
+// The compiled in table, see model_specs.cpp.
+const ModelSpec* model_specs(size_t& count);
+// nullptr if there is no spec with that name.
+const ModelSpec* find_model_spec(const std::string& name);
+// Matches the spec name against the model file name, so
+// "assets/yolov5_detector.param" and "ssrnet_age_float16.tflite" both resolve.
+// The longest matching name wins ("fsanet-var" over "fsanet").
+const ModelSpec* find_model_spec_for_model(const std::string& model_path);
+
+} // namespace mei
+
+#endif // MEI_MODEL_SPEC_H_
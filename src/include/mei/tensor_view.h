@@ -0,0 +1,95 @@
+#ifndef MEI_TENSOR_VIEW_H_
+#define MEI_TENSOR_VIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mei {
+
+enum class DataType : uint8_t {
+    Float32,
+    Float16,
+    UInt8,
+    Int8,
+    Int32,
+    Int64,
+};
+
+enum class Layout : uint8_t {
+    // No particular image layout (1D/2D outputs, or whatever the engine expects).
+    Any,
+    NCHW,
+    NHWC,
+    // MNN's packed layout: logical NCHW, stored as [N, ceil(C/4), H, W, 4].
+    NC4HW4,
+};
+
+size_t dtype_size(DataType dtype);
+
+// Affine quantization of UInt8 / Int8 tensors: real = (q - zero_point) * scale.
+// The default is the identity, what raw 8-bit inputs use.
+struct Quantization {
+    float scale = 1.f;
+    int32_t zero_point = 0;
+};
+
+// Non-owning view of an n-dimensional tensor: engines hand out views of their
+// own buffers (MNN host tensor, ncnn::Mat, Ort::Value, TfLiteTensor, TNN Mat)
+// instead of copying into a std::vector.
+//
+// shape is given in the order of the layout (NHWC tensors list N, H, W, C).
+// strides are in elements and describe the storage for every layout but
+// NC4HW4, where only strides[0] (the batch stride) is meaningful.
+struct TensorView {
+    static constexpr int kMaxDims = 6;
+
+    void* data = nullptr;
+    DataType dtype = DataType::Float32;
+    Layout layout = Layout::Any;
+    int ndim = 0;
+    int64_t shape[kMaxDims] = {};
+    int64_t strides[kMaxDims] = {};
+    // Only meaningful for UInt8 / Int8.
+    Quantization quant;
+
+    // Row-major contiguous view, strides derived from the shape.
+    static TensorView dense(void* data, const int64_t* shape, int ndim,
+                            DataType dtype = DataType::Float32, Layout layout = Layout::Any);
+    static TensorView dense(void* data, const std::vector<int64_t>& shape,
+                            DataType dtype = DataType::Float32, Layout layout = Layout::Any) {
+        return dense(data, shape.data(), static_cast<int>(shape.size()), dtype, layout);
+    }
+
+    std::vector<int64_t> shape_vector() const { return std::vector<int64_t>(shape, shape + ndim); }
+    int64_t element_count() const;
+    // Bytes spanned by the storage, including NC4HW4 channel padding and row pitch.
+    size_t storage_bytes() const;
+    // True if the elements are laid out row-major without gaps.
+    bool is_dense() const;
+
+    template <typename T>
+    T* ptr() const { return static_cast<T*>(data); }
+};
+
+// Copies src into dst, converting layout (NCHW / NHWC / NC4HW4) and strides as
+// needed. Both views must describe the same logical tensor and dtype. Returns
+// false for combinations it cannot map.
+bool copy_tensor(const TensorView& src, const TensorView& dst);
+
+// Converts a dense UInt8 / Int8 view to float32 with its quantization into
+// dst, which holds src.element_count() floats. False for other views.
+bool dequantize(const TensorView& src, float* dst);
+
+// Owning dense tensor, mostly for callers that build inputs by hand.
+struct Tensor {
+    std::vector<int64_t> shape;
+    std::vector<float> data;
+    Layout layout = Layout::Any;
+
+    TensorView view() { return TensorView::dense(data.data(), shape, DataType::Float32, layout); }
+};
+
+} // namespace mei
+
+#endif // MEI_TENSOR_VIEW_H_
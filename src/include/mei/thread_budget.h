@@ -0,0 +1,66 @@
+#ifndef MEI_THREAD_BUDGET_H_
+#define MEI_THREAD_BUDGET_H_
+
+#include <mutex>
+#include <vector>
+
+namespace mei {
+
+class Engine;
+
+// Threads (and, with pinning, cores) handed to one engine.
+struct ThreadGrant {
+    int num_threads = 1;
+    // Logical cores the engine's threads should run on, empty when pinning is off.
+    std::vector<int> cpus;
+};
+
+// Splits the machine between every loaded engine of the process, so engines
+// running side by side do not each spin up a full set of threads and fight
+// over the same cores.
+//
+// Each engine joins with EngineConfig::num_threads as its request. Cores are
+// shared out fairly: engines asking for less than an equal share keep their
+// request, the rest split what is left, everyone gets at least one thread.
+// Loading or unloading an engine rebalances the others; they pick the new
+// grant up at their next infer() through their native knobs (MNN numThread,
+// ncnn opt.num_threads, ORT intra-op threads, TFLite SetNumThreads, TNN
+// SetCpuNumThreads). With pinning on, engines also get disjoint core ranges,
+// applied where the backend has a knob for it (ncnn, ONNXRuntime).
+class ThreadBudget {
+public:
+    static ThreadBudget& instance();
+
+    // Cores to share out, by default $MEI_THREAD_BUDGET or the hardware
+    // thread count.
+    void set_total(int cores);
+    int total() const;
+    void set_pinning(bool pin);
+    bool pinning() const;
+
+    // Called by engines on load / unload. attach() returns the joining
+    // engine's grant, the others are notified of theirs.
+    ThreadGrant attach(Engine* engine, int requested);
+    void detach(Engine* engine);
+
+private:
+    ThreadBudget();
+
+    struct Member {
+        Engine* engine;
+        int requested;
+        ThreadGrant grant;
+    };
+    // Recomputes every grant and notifies the engines whose grant changed,
+    // except `joining`.
+    void rebalance_locked(const Engine* joining);
+
+    mutable std::mutex mutex_;
+    int total_;
+    bool pin_ = false;
+    std::vector<Member> members_;
+};
+
+} // namespace mei
+
+#endif // MEI_THREAD_BUDGET_H_
@@ -0,0 +1,49 @@
+#ifndef MEI_THREAD_POOL_H_
+#define MEI_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mei {
+
+// Fixed set of worker threads running queued tasks in FIFO order.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads);
+    // Finishes the queued tasks, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task);
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Runs fn(0) .. fn(count - 1) on the calling thread and up to count - 1
+    // workers, returning once all are done. The caller takes indices itself
+    // until none are left and only waits for the ones workers already
+    // started, so it cannot deadlock when called from a worker or while the
+    // queue is busy; it just gets less help.
+    void parallel_for(int count, const std::function<void(int)>& fn);
+
+    // Process wide pool, one worker per hardware thread. Runs the asynchronous
+    // inference of engines without a native async API.
+    static ThreadPool& shared();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+} // namespace mei
+
+#endif // MEI_THREAD_POOL_H_
@@ -0,0 +1,91 @@
+#ifndef MEI_LRU_CACHE_H_
+#define MEI_LRU_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "mei/tensor_view.h"
+
+namespace mei {
+
+// Small bounded cache with least recently used eviction. Meant for a handful
+// of entries (one per recurring input shape), so lookup is a linear scan of a
+// list kept in recency order: cheaper than hashing the key at these sizes.
+// Values are destroyed on eviction and must release their resources then.
+// Pointers returned by find()/insert() stay valid until that entry is evicted.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity = 1) : capacity_(capacity < 1 ? 1 : capacity) {}
+
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity < 1 ? 1 : capacity;
+        while (items_.size() > capacity_) {
+            items_.pop_back();
+        }
+    }
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return items_.size(); }
+
+    // Marks the entry as most recently used. nullptr on a miss.
+    Value* find(const Key& key) {
+        for (auto it = items_.begin(); it != items_.end(); ++it) {
+            if (it->first == key) {
+                if (it != items_.begin()) {
+                    items_.splice(items_.begin(), items_, it);
+                }
+                return &items_.front().second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Inserts (or replaces) the entry, evicting the least recently used one
+    // when the cache is full.
+    Value& insert(const Key& key, Value value) {
+        for (auto it = items_.begin(); it != items_.end(); ++it) {
+            if (it->first == key) {
+                items_.erase(it);
+                break;
+            }
+        }
+        if (items_.size() >= capacity_) {
+            items_.pop_back();
+        }
+        items_.emplace_front(key, std::move(value));
+        return items_.front().second;
+    }
+
+    // Visits every entry, without touching the recency order.
+    template <typename Fn>
+    void for_each(Fn fn) {
+        for (auto& item : items_) {
+            fn(item.second);
+        }
+    }
+
+    void clear() { items_.clear(); }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<Key, Value>> items_;
+};
+
+// Cache key for a set of input shapes: rank and dims of every input, in order.
+using ShapeKey = std::vector<int64_t>;
+
+inline ShapeKey make_shape_key(const std::vector<TensorView>& inputs) {
+    ShapeKey key;
+    for (const TensorView& v : inputs) {
+        key.push_back(v.ndim);
+        key.insert(key.end(), v.shape, v.shape + v.ndim);
+    }
+    return key;
+}
+
+} // namespace mei
+
+#endif // MEI_LRU_CACHE_H_
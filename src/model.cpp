@@ -0,0 +1,386 @@
+#include "mei/model.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "mei/autotune.h"
+#include "postprocess.h"
+#include "preprocess.h"
+
+namespace mei {
+
+static size_t required_outputs(DecoderKind decoder) {
+    return decoder == DecoderKind::UltraFace || decoder == DecoderKind::UltraFaceRegression ? 2 : 1;
+}
+
+bool Model::load(const std::string& model_path, const EngineConfig& config) {
+    const ModelSpec* spec = find_model_spec_for_model(model_path);
+    if (!spec) {
+        std::cerr << "Model: no spec matches " << model_path << std::endl;
+        return false;
+    }
+    // A tuned host runs the fastest measured file / engine instead, with the
+    // settings autotune measured (threads and backend knobs) over the
+    // caller's config; everything else stays as the caller asked.
+    if (const TuneEntry* tuned = TuneProfile::instance().find(spec->name)) {
+        EngineConfig tuned_config = config;
+        tuned_config.num_threads = tuned->config.num_threads;
+        tuned_config.ncnn_winograd = tuned->config.ncnn_winograd;
+        tuned_config.ncnn_sgemm = tuned->config.ncnn_sgemm;
+        tuned_config.ncnn_packing = tuned->config.ncnn_packing;
+        tuned_config.ort_graph_opt_level = tuned->config.ort_graph_opt_level;
+        tuned_config.tflite_xnnpack = tuned->config.tflite_xnnpack;
+        tuned_config.mnn_precision = tuned->config.mnn_precision;
+        return load(*spec, tuned->model_path, tuned_config);
+    }
+    return load(*spec, model_path, config);
+}
+
+bool Model::load(const ModelSpec& spec, const std::string& model_path, const EngineConfig& config) {
+    unload();
+    engine_ = create_engine_for_model(model_path);
+    if (!engine_ || !engine_->load(model_files_for(model_path), config)) {
+        std::cerr << "Model: failed to load " << model_path << std::endl;
+        unload();
+        return false;
+    }
+    if (engine_->input_names().size() != 1) {
+        std::cerr << "Model: " << spec.name << " expects a single input, got "
+                  << engine_->input_names().size() << std::endl;
+        unload();
+        return false;
+    }
+
+    // Names -> indices, once. A name the exported model does not use falls
+    // back to its position in the spec.
+    const std::vector<std::string>& names = engine_->output_names();
+    for (int i = 0; i < ModelSpec::kMaxOutputs && spec.output_names[i]; i++) {
+        size_t index = i;
+        for (size_t j = 0; j < names.size(); j++) {
+            if (names[j] == spec.output_names[i]) {
+                index = j;
+                break;
+            }
+        }
+        output_indexes_.push_back(index);
+    }
+    if (output_indexes_.empty()) {
+        output_indexes_.push_back(0);
+    }
+    for (size_t index : output_indexes_) {
+        if (index >= names.size()) {
+            std::cerr << "Model: " << spec.name << " needs more outputs than the model has" << std::endl;
+            unload();
+            return false;
+        }
+    }
+    if (output_indexes_.size() < required_outputs(spec.decoder)) {
+        std::cerr << "Model: " << spec.name << " lists too few outputs for its decoder" << std::endl;
+        unload();
+        return false;
+    }
+
+    // Write the engine's native layout and type directly, no conversion in
+    // infer(). Quantized inputs get their bytes straight from the tables.
+    const Layout layout = engine_->input_layouts().empty() ? Layout::NCHW : engine_->input_layouts()[0];
+    const bool nhwc = layout == Layout::NHWC;
+    const DataType dtype = engine_->input_dtype(0);
+    if (dtype != DataType::Float32 && dtype != DataType::UInt8 && dtype != DataType::Int8) {
+        std::cerr << "Model: " << spec.name << " input must be float32, uint8 or int8" << std::endl;
+        unload();
+        return false;
+    }
+    for (int f = 0; f < kPixelFormatCount; f++) {
+        normalize_[f] = select_normalize(static_cast<PixelFormat>(f), spec.color, layout, dtype);
+    }
+    // 8-bit inputs without quantization parameters (ONNX graph inputs never
+    // carry any) take the raw 0-255 pixels and normalize inside the graph:
+    // quantizing the spec's normalized values at scale 1 would clamp them.
+    const Quantization quant = engine_->input_quant(0);
+    const bool raw_pixels = dtype != DataType::Float32 && quant.scale == 1.f && quant.zero_point == 0;
+    static const float kRawMean[3] = {0.f, 0.f, 0.f};
+    static const float kRawNorm[3] = {1.f, 1.f, 1.f};
+    make_normalize_params(raw_pixels ? kRawMean : spec.mean, raw_pixels ? kRawNorm : spec.norm,
+                          spec.input_channels(), normalize_params_, dtype, quant);
+    decode_ = select_decoder(spec);
+    input_layout_ = nhwc ? Layout::NHWC : Layout::NCHW;
+
+    const int64_t c = spec.input_channels();
+    const int64_t h = spec.input_height;
+    const int64_t w = spec.input_width;
+    const std::vector<int64_t> shape = nhwc ? std::vector<int64_t>{1, h, w, c} : std::vector<int64_t>{1, c, h, w};
+    input_data_.assign(static_cast<size_t>(c * h * w) * dtype_size(dtype), 0);
+    inputs_.assign(1, TensorView::dense(input_data_.data(), shape, dtype, nhwc ? Layout::NHWC : Layout::NCHW));
+    inputs_[0].quant = engine_->input_quant(0);
+    decoder_outputs_.resize(output_indexes_.size());
+    output_copies_.resize(output_indexes_.size());
+
+    // A batch dimension the model leaves open is packed up to max_batch,
+    // a fixed one is filled as declared.
+    const std::vector<int64_t>& declared = engine_->input_shapes()[0];
+    dynamic_batch_ = !declared.empty() && declared[0] <= 0;
+    batch_limit_ = dynamic_batch_ ? std::max(config.max_batch, 1) : (declared.empty() ? 1 : declared[0]);
+    spec_ = &spec;
+
+    // Engines skip warmup for dynamic input shapes (ncnn declares none at
+    // all); the spec knows the real one, warm up at it here.
+    if (std::any_of(declared.begin(), declared.end(), [](int64_t d) { return d <= 0; })) {
+        for (int i = 0; i < config.warmup_runs; i++) {
+            if (!engine_->infer(inputs_, outputs_)) {
+                std::cerr << "Model: " << spec.name << " warmup forward failed" << std::endl;
+                unload();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Model::preprocess(const ImageView& image, const TensorView& dst, InputTransform& transform) {
+    if (!spec_ || image.empty()) {
+        return false;
+    }
+    const PixelFormat rows = kernel_format(image.format, spec_->input_channels());
+    const NormalizeFn normalize = normalize_[static_cast<int>(rows)];
+    const int w = spec_->input_width;
+    const int h = spec_->input_height;
+    // Preprocessing runs right before the engine's own threads, on as many.
+    const int threads = engine_->granted_threads();
+    bool ok = false;
+    switch (spec_->resize) {
+    case ResizeMode::Stretch:
+        // Straight from the source image to the input tensor, one pass.
+        ok = resize_normalize(image, normalize, spec_->input_channels(), normalize_params_, dst, threads);
+        transform.scale_x = static_cast<float>(w) / image.width;
+        transform.scale_y = static_cast<float>(h) / image.height;
+        transform.dx = transform.dy = 0.f;
+        break;
+    case ResizeMode::Letterbox:
+        ok = letterbox_normalize(image, normalize, spec_->input_channels(), normalize_params_,
+                                 spec_->resize_param, dst, transform, threads);
+        break;
+    case ResizeMode::Pad: {
+        // The padded canvas is only virtual: the crop reads zeros outside the image.
+        const int nw = static_cast<int>(image.width + spec_->resize_param * image.width);
+        const int nh = static_cast<int>(image.height + spec_->resize_param * image.height);
+        ok = crop_normalize(image, -(nw - image.width) / 2, -(nh - image.height) / 2, nw, nh, normalize,
+                            spec_->input_channels(), normalize_params_, dst, transform, threads);
+        break;
+    }
+    }
+    if (!ok) {
+        std::cerr << "Model: " << spec_->name << " cannot write its input into the given tensor" << std::endl;
+    }
+    return ok;
+}
+
+bool Model::preprocess(const YuvImageView& image, const TensorView& dst, InputTransform& transform) {
+    if (!spec_ || image.empty()) {
+        return false;
+    }
+    // The 4:2:0 pipelines hand the kernels BGR rows.
+    const NormalizeFn normalize = normalize_[static_cast<int>(PixelFormat::BGR)];
+    const int threads = engine_->granted_threads();
+    bool ok = false;
+    switch (spec_->resize) {
+    case ResizeMode::Stretch:
+        ok = resize_normalize(image, normalize, spec_->input_channels(), normalize_params_, dst, threads);
+        transform.scale_x = static_cast<float>(spec_->input_width) / image.width;
+        transform.scale_y = static_cast<float>(spec_->input_height) / image.height;
+        transform.dx = transform.dy = 0.f;
+        break;
+    case ResizeMode::Letterbox:
+        ok = letterbox_normalize(image, normalize, spec_->input_channels(), normalize_params_,
+                                 spec_->resize_param, dst, transform, threads);
+        break;
+    case ResizeMode::Pad:
+        // Padding works on whole 8-bit images, convert first.
+        yuv_to_bgr(image, frame_);
+        return preprocess(ImageView::packed(frame_.data(), image.width, image.height, PixelFormat::BGR), dst,
+                          transform);
+    }
+    if (!ok) {
+        std::cerr << "Model: " << spec_->name << " cannot write its input into the given tensor" << std::endl;
+    }
+    return ok;
+}
+
+bool Model::decode(const std::vector<TensorView>& outputs, const InputTransform& transform, Prediction& result) {
+    // Decoders walk plain float arrays; strided or packed outputs (ncnn cstep,
+    // MNN NC4HW4) are compacted first.
+    for (size_t i = 0; i < output_indexes_.size(); i++) {
+        const TensorView& out = outputs[output_indexes_[i]];
+        std::vector<uint8_t>& copy = output_copies_[i];
+        if (out.dtype == DataType::UInt8 || out.dtype == DataType::Int8) {
+            // Fully quantized models: the decoders see real values.
+            copy.resize(static_cast<size_t>(out.element_count()) * sizeof(float));
+            decoder_outputs_[i] = TensorView::dense(copy.data(), out.shape, out.ndim, DataType::Float32, out.layout);
+            if (!dequantize(out, decoder_outputs_[i].ptr<float>())) {
+                std::cerr << "Model: " << spec_->name << " output " << i << " cannot be dequantized" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        if (out.dtype != DataType::Float32) {
+            std::cerr << "Model: " << spec_->name << " output " << i << " is not float32" << std::endl;
+            return false;
+        }
+        if (out.is_dense() && out.layout != Layout::NC4HW4) {
+            decoder_outputs_[i] = out;
+            continue;
+        }
+        copy.resize(static_cast<size_t>(out.element_count()) * sizeof(float));
+        decoder_outputs_[i] = TensorView::dense(copy.data(), out.shape, out.ndim, DataType::Float32,
+                                                out.layout == Layout::NC4HW4 ? Layout::NCHW : out.layout);
+        if (!copy_tensor(out, decoder_outputs_[i])) {
+            return false;
+        }
+    }
+    decode_(*spec_, decoder_outputs_, transform, result);
+    return true;
+}
+
+template <typename Image>
+bool Model::predict_image(const Image& image, Prediction& result) {
+    result.detections.clear();
+    result.values.clear();
+    // Preprocessed straight into the engine's input memory, so the pixels
+    // are written once and infer() has nothing to copy.
+    TensorView dst = engine_->input_view(0, inputs_[0].shape_vector());
+    if (!dst.data || dst.dtype != inputs_[0].dtype) {
+        dst = inputs_[0];
+    }
+    engine_inputs_.assign(1, dst);
+    InputTransform transform;
+    if (!preprocess(image, dst, transform)) {
+        return false;
+    }
+    return engine_->infer(engine_inputs_, outputs_) && decode(outputs_, transform, result);
+}
+
+bool Model::predict(const ImageView& image, Prediction& result) {
+    return predict_image(image, result);
+}
+
+bool Model::predict(const YuvImageView& image, Prediction& result) {
+    return predict_image(image, result);
+}
+
+void Model::submit(const ImageView& image, PredictCallback done) {
+    std::unique_ptr<std::vector<uint8_t>> input;
+    {
+        std::lock_guard<std::mutex> lock(free_inputs_mutex_);
+        if (!free_inputs_.empty()) {
+            input = std::move(free_inputs_.back());
+            free_inputs_.pop_back();
+        }
+    }
+    if (!input) {
+        input.reset(new std::vector<uint8_t>(input_data_.size()));
+    }
+
+    std::vector<TensorView> inputs = inputs_;
+    inputs[0].data = input->data();
+    InputTransform transform;
+    if (!preprocess(image, inputs[0], transform)) {
+        Prediction empty;
+        done(false, empty);
+        return;
+    }
+    std::shared_ptr<std::vector<uint8_t>> owned(input.release());
+    engine_->submit(inputs, [this, owned, transform, done](bool ok, const std::vector<TensorView>& outputs) {
+        // Jobs on one engine run one at a time, decode's scratch is not shared.
+        Prediction result;
+        ok = ok && decode(outputs, transform, result);
+        {
+            std::lock_guard<std::mutex> lock(free_inputs_mutex_);
+            free_inputs_.emplace_back(new std::vector<uint8_t>(std::move(*owned)));
+        }
+        done(ok, result);
+    });
+}
+
+bool Model::predict_batch(const std::vector<ImageView>& images, std::vector<Prediction>& results) {
+    results.assign(images.size(), Prediction());
+    if (!spec_) {
+        return false;
+    }
+    const size_t item_size = input_data_.size();
+    batch_data_.resize(static_cast<size_t>(batch_limit_) * item_size);
+    batch_transforms_.resize(static_cast<size_t>(batch_limit_));
+
+    for (size_t first = 0; first < images.size(); first += static_cast<size_t>(batch_limit_)) {
+        const int64_t count = std::min<int64_t>(batch_limit_, static_cast<int64_t>(images.size() - first));
+        // Dynamic batches are rounded up to a power of two, so a varying
+        // number of images maps onto a few cached shapes.
+        int64_t batch = batch_limit_;
+        if (dynamic_batch_) {
+            batch = 1;
+            while (batch < count) batch *= 2;
+            batch = std::min(batch, batch_limit_);
+        }
+        TensorView item = inputs_[0];
+        for (int64_t i = 0; i < count; i++) {
+            item.data = batch_data_.data() + i * item_size;
+            if (!preprocess(images[first + i], item, batch_transforms_[i])) {
+                return false;
+            }
+        }
+        std::fill(batch_data_.begin() + count * item_size, batch_data_.begin() + batch * item_size, 0);
+
+        std::vector<int64_t> shape = inputs_[0].shape_vector();
+        shape[0] = batch;
+        batch_inputs_.assign(1, TensorView::dense(batch_data_.data(), shape, inputs_[0].dtype, inputs_[0].layout));
+        batch_inputs_[0].quant = inputs_[0].quant;
+        if (!engine_->infer(batch_inputs_, batch_outputs_)) {
+            return false;
+        }
+
+        // Item i of every output is its batch stride in.
+        item_outputs_ = batch_outputs_;
+        for (size_t index : output_indexes_) {
+            if (batch_outputs_[index].ndim == 0 || batch_outputs_[index].shape[0] != batch) {
+                std::cerr << "Model: " << spec_->name << " output " << index << " has no batch dimension" << std::endl;
+                return false;
+            }
+            item_outputs_[index].shape[0] = 1;
+        }
+        for (int64_t i = 0; i < count; i++) {
+            for (size_t index : output_indexes_) {
+                const TensorView& out = batch_outputs_[index];
+                item_outputs_[index].data = static_cast<uint8_t*>(out.data) +
+                                            i * out.strides[0] * static_cast<int64_t>(dtype_size(out.dtype));
+            }
+            if (!decode(item_outputs_, batch_transforms_[i], results[first + i])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Model::wait_idle() {
+    if (engine_) {
+        engine_->wait_idle();
+    }
+}
+
+void Model::unload() {
+    if (engine_) {
+        engine_->unload();
+    }
+    engine_.reset();
+    spec_ = nullptr;
+    output_indexes_.clear();
+    inputs_.clear();
+    engine_inputs_.clear();
+    outputs_.clear();
+    decoder_outputs_.clear();
+    output_copies_.clear();
+    free_inputs_.clear();
+    batch_inputs_.clear();
+    batch_outputs_.clear();
+    item_outputs_.clear();
+}
+
+} // namespace mei
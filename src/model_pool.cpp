@@ -0,0 +1,265 @@
+#include "mei/model_pool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+namespace mei {
+
+// Resident set size of the process, 0 where /proc is not available.
+static size_t rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+static size_t file_bytes(const std::string& path) {
+    if (path.empty()) {
+        return 0;
+    }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+// Weights are resident at least once, whatever the engine does with them.
+static size_t model_file_bytes(const std::string& model_path) {
+    ModelFiles files = model_files_for(model_path);
+    return file_bytes(files.model_path) + file_bytes(files.weights_path);
+}
+
+ModelPool::ModelPool(size_t budget_bytes, const EngineConfig& config)
+    : config_(config), budget_(budget_bytes) {
+    worker_ = std::thread(&ModelPool::worker_loop, this);
+}
+
+ModelPool::~ModelPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queue_cv_.notify_all();
+    worker_.join();
+}
+
+bool ModelPool::add(const std::string& key, const std::string& model_path) {
+    const ModelSpec* spec = find_model_spec_for_model(model_path);
+    if (!spec) {
+        std::cerr << "ModelPool: no spec matches " << model_path << std::endl;
+        return false;
+    }
+    return add(key, *spec, model_path);
+}
+
+bool ModelPool::add(const std::string& key, const ModelSpec& spec, const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(key)) {
+        std::cerr << "ModelPool: " << key << " is already registered" << std::endl;
+        return false;
+    }
+    std::unique_ptr<Entry> e(new Entry);
+    e->key = key;
+    e->spec = &spec;
+    e->model_path = model_path;
+    entries_[key] = std::move(e);
+    return true;
+}
+
+ModelPool::Entry* ModelPool::find(const std::string& key) const {
+    auto it = entries_.find(key);
+    return it == entries_.end() ? nullptr : it->second.get();
+}
+
+bool ModelPool::make_room_locked(size_t needed, const Entry* keep) {
+    while (resident_ + needed > budget_) {
+        Entry* victim = nullptr;
+        for (const auto& kv : entries_) {
+            Entry* e = kv.second.get();
+            if (e == keep || !e->model || e->in_use > 0 || e->loading) continue;
+            if (!victim || e->last_used < victim->last_used) victim = e;
+        }
+        if (!victim) {
+            return false;
+        }
+        victim->model.reset();
+        resident_ -= victim->footprint;
+        victim->evicted = true;
+    }
+    return true;
+}
+
+bool ModelPool::load_locked(Entry* entry, std::unique_lock<std::mutex>& lock, bool allow_evict) {
+    // The footprint is the RSS growth over the model's first load, so nothing
+    // else may allocate or free meanwhile: hold new predict() / unload() calls
+    // and other loads back and let the running ones finish first. Reloads
+    // reuse that footprint and run alongside the traffic.
+    const bool measure = entry->footprint == 0;
+    entry->loading = true;
+    loaded_cv_.wait(lock, [this] { return !measuring_; });
+    if (measure) {
+        measuring_ = true;
+        loaded_cv_.wait(lock, [this] { return running_ == 0 && loads_ == 0; });
+    }
+    loads_++;
+
+    const size_t estimate = entry->footprint ? entry->footprint : model_file_bytes(entry->model_path);
+    if (resident_ + estimate > budget_ && (!allow_evict || !make_room_locked(estimate, entry))) {
+        if (allow_evict) {
+            std::cerr << "ModelPool: no room for " << entry->key << " (" << estimate << " bytes, "
+                      << resident_ << " of " << budget_ << " in use)" << std::endl;
+        }
+        if (measure) measuring_ = false;
+        loads_--;
+        entry->loading = false;
+        loaded_cv_.notify_all();
+        return false;
+    }
+
+    lock.unlock();
+    std::unique_ptr<Model> model(new Model);
+    const size_t before = measure ? rss_bytes() : 0;
+    bool ok = model->load(*entry->spec, entry->model_path, config_);
+    const size_t after = measure ? rss_bytes() : 0;
+    lock.lock();
+
+    if (measure) measuring_ = false;
+    loads_--;
+    entry->loading = false;
+    if (ok) {
+        size_t footprint = entry->footprint;
+        if (measure) {
+            footprint = std::max(after > before ? after - before : 0, model_file_bytes(entry->model_path));
+            entry->footprint = footprint;
+        }
+        // The estimate may have been low. A reload must fit in the free room;
+        // a load may evict others, but not models that are in use.
+        if (resident_ + footprint > budget_ && (!allow_evict || !make_room_locked(footprint, entry))) {
+            std::cerr << "ModelPool: " << entry->key << " needs " << footprint << " bytes once loaded, "
+                      << resident_ << " of " << budget_ << " in use, unloading it again" << std::endl;
+            model.reset();
+            ok = false;
+        } else {
+            entry->model = std::move(model);
+            entry->evicted = false;
+            resident_ += footprint;
+        }
+    }
+    loaded_cv_.notify_all();
+    return ok;
+}
+
+void ModelPool::schedule_reloads_locked() {
+    size_t planned = resident_;
+    for (const auto& kv : entries_) {
+        Entry* e = kv.second.get();
+        if (!e->evicted || e->model || e->loading) continue;
+        if (planned + e->footprint <= budget_) {
+            reload_queue_.emplace_back(e->key, false);
+            planned += e->footprint;
+        }
+    }
+    if (!reload_queue_.empty()) {
+        queue_cv_.notify_one();
+    }
+}
+
+bool ModelPool::predict(const std::string& key, const ImageView& image, Prediction& result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Entry* e = find(key);
+    if (!e) {
+        std::cerr << "ModelPool: unknown model " << key << std::endl;
+        return false;
+    }
+    e->last_used = ++clock_;
+    loaded_cv_.wait(lock, [this, e] { return !e->loading && !measuring_; });
+    if (!e->model && !load_locked(e, lock, true)) {
+        return false;
+    }
+    e->in_use++;
+    running_++;
+    lock.unlock();
+
+    bool ok;
+    {
+        std::lock_guard<std::mutex> run_lock(e->run_mutex);
+        ok = e->model->predict(image, result);
+    }
+
+    lock.lock();
+    e->in_use--;
+    running_--;
+    if (e->in_use == 0 || running_ == 0) {
+        loaded_cv_.notify_all();
+    }
+    return ok;
+}
+
+void ModelPool::prefetch(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reload_queue_.emplace_back(key, true);
+    queue_cv_.notify_one();
+}
+
+void ModelPool::unload(const std::string& key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Entry* e = find(key);
+    if (!e) return;
+    loaded_cv_.wait(lock, [this, e] { return !e->loading && e->in_use == 0 && !measuring_; });
+    if (e->model) {
+        e->model.reset();
+        resident_ -= e->footprint;
+    }
+    e->evicted = false;
+    schedule_reloads_locked();
+}
+
+void ModelPool::set_budget(size_t budget_bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    loaded_cv_.wait(lock, [this] { return !measuring_; });
+    budget_ = budget_bytes;
+    make_room_locked(0, nullptr);
+    schedule_reloads_locked();
+}
+
+size_t ModelPool::budget_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_;
+}
+
+size_t ModelPool::resident_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_;
+}
+
+bool ModelPool::resident(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* e = find(key);
+    return e && e->model;
+}
+
+size_t ModelPool::footprint(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* e = find(key);
+    return e ? e->footprint : 0;
+}
+
+void ModelPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queue_cv_.wait(lock, [this] { return stop_ || !reload_queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        std::pair<std::string, bool> item = reload_queue_.front();
+        reload_queue_.pop_front();
+        Entry* e = find(item.first);
+        if (!e || e->model || e->loading) continue;
+        load_locked(e, lock, item.second);
+    }
+}
+
+} // namespace mei
@@ -0,0 +1,93 @@
+#include "mei/model_spec.h"
+
+#include <cstring>
+
+namespace mei {
+
+// Values taken from the per-engine examples. Where the examples disagree, the
+// entry says which one it follows.
+static const ModelSpec kModelSpecs[] = {
+    {"yolov5_detector", 640, 640, PixelFormat::RGB,
+     {0.f, 0.f, 0.f}, {1 / 255.f, 1 / 255.f, 1 / 255.f},
+     ResizeMode::Letterbox, 114.f, DecoderKind::Yolov5, 80, 0.25f, 0.45f, 300, false,
+     {"pred"}, false},
+    {"ultraface_detector", 320, 240, PixelFormat::RGB,
+     {127.f, 127.f, 127.f}, {1 / 128.f, 1 / 128.f, 1 / 128.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::UltraFace, 0, 0.5f, 0.3f, 0, true,
+     {"scores", "boxes"}, false},
+    // UltraFace exported without its box decode ops, e.g.
+    // "ultraface_detector_regression.onnx".
+    {"ultraface_detector_regression", 320, 240, PixelFormat::RGB,
+     {127.f, 127.f, 127.f}, {1 / 128.f, 1 / 128.f, 1 / 128.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::UltraFaceRegression, 0, 0.5f, 0.3f, 0, true,
+     {"scores", "boxes"}, false},
+    {"pfld_landmarks", 112, 112, PixelFormat::RGB,
+     {127.5f, 127.5f, 127.5f}, {1 / 128.f, 1 / 128.f, 1 / 128.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::Raw, 0, 0.f, 0.f, 0, false,
+     {"output"}, true},
+    {"age_googlenet", 224, 224, PixelFormat::RGB,
+     {127.5f, 127.5f, 127.5f}, {1 / 128.f, 1 / 128.f, 1 / 128.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::Softmax, 0, 0.f, 0.f, 0, false,
+     {}, true},
+    {"gender_googlenet", 224, 224, PixelFormat::RGB,
+     {127.5f, 127.5f, 127.5f}, {1 / 128.f, 1 / 128.f, 1 / 128.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::Softmax, 0, 0.f, 0.f, 0, false,
+     {}, true},
+    // Raw 0-255 gray levels, no normalization.
+    {"emotion_ferplus", 64, 64, PixelFormat::Gray,
+     {0.f, 0.f, 0.f}, {1.f, 1.f, 1.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::Softmax, 0, 0.f, 0.f, 0, false,
+     {}, true},
+    // ImageNet mean / std on 0-255 pixels, RGB, as in the TFLite example. The
+    // examples differ here: ncnn and MNN use 0.229 as the third std, the
+    // ONNXRuntime one feeds BGR and TNN only scales to [0, 1].
+    {"ssrnet_age", 64, 64, PixelFormat::RGB,
+     {0.485f * 255.f, 0.456f * 255.f, 0.406f * 255.f},
+     {1 / (0.229f * 255.f), 1 / (0.224f * 255.f), 1 / (0.225f * 255.f)},
+     ResizeMode::Stretch, 0.f, DecoderKind::Raw, 0, 0.f, 0.f, 0, false,
+     {"age"}, true},
+    // Both FSA-Net heads share the preprocessing: 30% zero padding, BGR.
+    {"fsanet-var", 64, 64, PixelFormat::BGR,
+     {127.5f, 127.5f, 127.5f}, {1 / 127.5f, 1 / 127.5f, 1 / 127.5f},
+     ResizeMode::Pad, 0.3f, DecoderKind::Raw, 0, 0.f, 0.f, 0, false,
+     {"output"}, true},
+    {"fsanet-1x1", 64, 64, PixelFormat::BGR,
+     {127.5f, 127.5f, 127.5f}, {1 / 127.5f, 1 / 127.5f, 1 / 127.5f},
+     ResizeMode::Pad, 0.3f, DecoderKind::Raw, 0, 0.f, 0.f, 0, false,
+     {"output"}, true},
+    {"mnist", 28, 28, PixelFormat::Gray,
+     {0.f, 0.f, 0.f}, {1 / 255.f, 1 / 255.f, 1 / 255.f},
+     ResizeMode::Stretch, 0.f, DecoderKind::Softmax, 0, 0.f, 0.f, 0, false,
+     {}, true},
+};
+
+const ModelSpec* model_specs(size_t& count) {
+    count = sizeof(kModelSpecs) / sizeof(kModelSpecs[0]);
+    return kModelSpecs;
+}
+
+const ModelSpec* find_model_spec(const std::string& name) {
+    for (const ModelSpec& spec : kModelSpecs) {
+        if (name == spec.name) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+const ModelSpec* find_model_spec_for_model(const std::string& model_path) {
+    size_t slash = model_path.find_last_of("/\\");
+    const std::string file = slash == std::string::npos ? model_path : model_path.substr(slash + 1);
+    const ModelSpec* best = nullptr;
+    size_t best_len = 0;
+    for (const ModelSpec& spec : kModelSpecs) {
+        size_t len = strlen(spec.name);
+        if (len > best_len && file.compare(0, len, spec.name) == 0) {
+            best = &spec;
+            best_len = len;
+        }
+    }
+    return best;
+}
+
+} // namespace mei
@@ -0,0 +1,683 @@
+#include "postprocess.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEI_X86_SIMD 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MEI_NEON_SIMD 1
+#endif
+
+namespace mei {
+
+void DetectionBuffer::resize(size_t n) {
+    x1.resize(n);
+    y1.resize(n);
+    x2.resize(n);
+    y2.resize(n);
+    score.resize(n);
+    label.resize(n);
+}
+
+void DetectionBuffer::push_back(float bx1, float by1, float bx2, float by2, float s, int l) {
+    x1.push_back(bx1);
+    y1.push_back(by1);
+    x2.push_back(bx2);
+    y2.push_back(by2);
+    score.push_back(s);
+    label.push_back(l);
+}
+
+void DetectionBuffer::append_to(std::vector<Detection>& out) const {
+    const size_t first = out.size();
+    out.resize(first + size());
+    for (size_t i = 0; i < size(); i++) {
+        out[first + i] = {x1[i], y1[i], x2[i], y2[i], score[i], label[i]};
+    }
+}
+
+// Rows in [begin, end) of `length` floats whose `column` (objectness, face
+// score) is >= threshold, written to `rows` without a branch per row.
+// Returns how many.
+static size_t scan_column(const float* data, int64_t begin, int64_t end, int length, int column, float threshold,
+                          int* rows) {
+    size_t n = 0;
+    for (int64_t i = begin; i < end; i++) {
+        rows[n] = static_cast<int>(i);
+        n += data[i * length + column] >= threshold ? 1 : 0;
+    }
+    return n;
+}
+
+#if defined(MEI_X86_SIMD)
+
+#define MEI_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Eight rows per step: one gather of their column, one compare, and the set
+// bits of the mask become row indices. Element offsets must fit in int32.
+MEI_TARGET_AVX2 static size_t scan_column_avx2(const float* data, int64_t num_rows, int length, int column,
+                                               float threshold, int* rows) {
+    const __m256i step = _mm256_set1_epi32(8 * length);
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                        _mm256_set1_epi32(length)),
+                                     _mm256_set1_epi32(column));
+    const __m256 t = _mm256_set1_ps(threshold);
+    size_t n = 0;
+    int64_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        const __m256 values = _mm256_i32gather_ps(data, index, 4);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(values, t, _CMP_GE_OQ)));
+        while (mask) {
+            rows[n++] = static_cast<int>(i) + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+        index = _mm256_add_epi32(index, step);
+    }
+    return n + scan_column(data, i, num_rows, length, column, threshold, rows + n);
+}
+
+static bool cpu_has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+#endif
+
+// scan_column() over all num_rows rows, SIMD where the CPU has it. `rows`
+// must have room for num_rows.
+static size_t scan_rows(const float* data, int64_t num_rows, int length, int column, float threshold, int* rows) {
+#if defined(MEI_X86_SIMD)
+    if (cpu_has_avx2() && num_rows * length <= INT_MAX) {
+        return scan_column_avx2(data, num_rows, length, column, threshold, rows);
+    }
+#endif
+    return scan_column(data, 0, num_rows, length, column, threshold, rows);
+}
+
+// Class argmax and box of the candidate rows; kNumClasses == 0 takes the
+// count at run time.
+template <int kNumClasses>
+static void yolov5_candidates(const float* data, int num_classes, float threshold, const InputTransform& transform,
+                              size_t count, DetectionBuffer& out) {
+    const int classes = kNumClasses > 0 ? kNumClasses : num_classes;
+    const int length = classes + 5;
+    out.resize(count);
+    size_t n = 0;
+    for (size_t k = 0; k < count; k++) {
+        const float* p = data + static_cast<int64_t>(out.rows[k]) * length;
+        const float* scores = p + 5;
+        int label = 0;
+        float best = scores[0];
+        for (int c = 1; c < classes; c++) {
+            if (scores[c] > best) {
+                best = scores[c];
+                label = c;
+            }
+        }
+        const float score = p[4] * best;
+        if (score < threshold) continue;
+        out.x1[n] = (p[0] - 0.5f * p[2] - transform.dx) / transform.scale_x;
+        out.y1[n] = (p[1] - 0.5f * p[3] - transform.dy) / transform.scale_y;
+        out.x2[n] = (p[0] + 0.5f * p[2] - transform.dx) / transform.scale_x;
+        out.y2[n] = (p[1] + 0.5f * p[3] - transform.dy) / transform.scale_y;
+        out.score[n] = score;
+        out.label[n] = label;
+        n++;
+    }
+    out.resize(n);
+}
+
+void decode_yolov5(const float* data, int64_t num_rows, int num_classes, float score_threshold,
+                   const InputTransform& transform, DetectionBuffer& out) {
+    out.resize(0);
+    if (!data || num_rows <= 0 || num_rows > INT_MAX || num_classes <= 0) {
+        return;
+    }
+    const int length = num_classes + 5;
+    out.rows.resize(static_cast<size_t>(num_rows));
+    const size_t count = scan_rows(data, num_rows, length, 4, score_threshold, out.rows.data());
+    if (num_classes == 80) {
+        yolov5_candidates<80>(data, num_classes, score_threshold, transform, count, out);
+    } else {
+        yolov5_candidates<0>(data, num_classes, score_threshold, transform, count, out);
+    }
+}
+
+// UltraFace-slim / RFB feature maps and the anchor sizes of each, in input
+// pixels, as the reference implementation generates its priors.
+static const int kUltraFaceStrides[4] = {8, 16, 32, 64};
+static const std::vector<float> kUltraFaceMinBoxes[4] = {{10, 16, 24}, {32, 48}, {64, 96}, {128, 192, 256}};
+static constexpr float kUltraFaceCenterVariance = 0.1f;
+static constexpr float kUltraFaceSizeVariance = 0.2f;
+
+static float clip01(float v) {
+    return std::min(std::max(v, 0.f), 1.f);
+}
+
+static void make_ultraface_priors(int width, int height, std::vector<float>& priors) {
+    priors.clear();
+    for (int f = 0; f < 4; f++) {
+        const int stride = kUltraFaceStrides[f];
+        const int cols = (width + stride - 1) / stride;
+        const int rows = (height + stride - 1) / stride;
+        const float scale_w = static_cast<float>(width) / stride;
+        const float scale_h = static_cast<float>(height) / stride;
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < cols; x++) {
+                const float cx = clip01((x + 0.5f) / scale_w);
+                const float cy = clip01((y + 0.5f) / scale_h);
+                for (float size : kUltraFaceMinBoxes[f]) {
+                    priors.insert(priors.end(), {cx, cy, clip01(size / width), clip01(size / height)});
+                }
+            }
+        }
+    }
+}
+
+const std::vector<float>& ultraface_priors(int width, int height) {
+    // Each thread remembers the last size it asked for, so the steady state
+    // takes no lock.
+    thread_local int last_width = 0, last_height = 0;
+    thread_local const std::vector<float>* last = nullptr;
+    if (last && width == last_width && height == last_height) {
+        return *last;
+    }
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, std::unique_ptr<std::vector<float>>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<std::vector<float>>& priors = cache[{width, height}];
+    if (!priors) {
+        priors.reset(new std::vector<float>());
+        make_ultraface_priors(width, height, *priors);
+    }
+    last_width = width;
+    last_height = height;
+    last = priors.get();
+    return *last;
+}
+
+void decode_ultraface(const float* scores, const float* boxes, int64_t num_anchors, UltraFaceBoxes form,
+                      float score_threshold, int input_width, int input_height, const InputTransform& transform,
+                      DetectionBuffer& out) {
+    out.resize(0);
+    if (!scores || !boxes || num_anchors <= 0 || input_width <= 0 || input_height <= 0) {
+        return;
+    }
+    const float* priors = nullptr;
+    if (form == UltraFaceBoxes::Regression) {
+        const std::vector<float>& all = ultraface_priors(input_width, input_height);
+        priors = all.data();
+        num_anchors = std::min(num_anchors, static_cast<int64_t>(all.size() / 4));
+    }
+    if (num_anchors > INT_MAX) {
+        return;
+    }
+    out.rows.resize(static_cast<size_t>(num_anchors));
+    const size_t count = scan_rows(scores, num_anchors, 2, 1, score_threshold, out.rows.data());
+
+    // Normalized input coordinates -> source image pixels.
+    const float sx = input_width / transform.scale_x, dx = transform.dx / transform.scale_x;
+    const float sy = input_height / transform.scale_y, dy = transform.dy / transform.scale_y;
+    out.resize(count);
+    for (size_t k = 0; k < count; k++) {
+        const int64_t i = out.rows[k];
+        const float* b = boxes + i * 4;
+        float x1, y1, x2, y2;
+        if (priors) {
+            const float* p = priors + i * 4;
+            const float cx = b[0] * kUltraFaceCenterVariance * p[2] + p[0];
+            const float cy = b[1] * kUltraFaceCenterVariance * p[3] + p[1];
+            const float w = std::exp(b[2] * kUltraFaceSizeVariance) * p[2];
+            const float h = std::exp(b[3] * kUltraFaceSizeVariance) * p[3];
+            x1 = clip01(cx - 0.5f * w);
+            y1 = clip01(cy - 0.5f * h);
+            x2 = clip01(cx + 0.5f * w);
+            y2 = clip01(cy + 0.5f * h);
+        } else {
+            x1 = b[0];
+            y1 = b[1];
+            x2 = b[2];
+            y2 = b[3];
+        }
+        out.x1[k] = x1 * sx - dx;
+        out.y1[k] = y1 * sy - dy;
+        out.x2[k] = x2 * sx - dx;
+        out.y2[k] = y2 * sy - dy;
+        out.score[k] = scores[i * 2 + 1];
+        out.label[k] = 1; // face
+    }
+}
+
+// NMS works on a score sorted copy of the boxes, structure of arrays padded
+// to whole blocks of kNmsBlock with empty boxes at (0, 0) (no intersection
+// with anything, label -1), so the block kernels have no tail.
+static constexpr size_t kNmsBlock = 64;
+
+struct NmsBoxes {
+    std::vector<float> x1, y1, x2, y2, area;
+    std::vector<int> label;
+
+    // Room for `capacity` boxes, empty from `n` on.
+    void reset(size_t n, size_t capacity) {
+        const size_t padded = (capacity + kNmsBlock - 1) / kNmsBlock * kNmsBlock;
+        for (std::vector<float>* v : {&x1, &y1, &x2, &y2, &area}) {
+            v->resize(padded);
+            std::fill(v->begin() + n, v->end(), 0.f);
+        }
+        label.resize(padded);
+        std::fill(label.begin() + n, label.end(), -1);
+    }
+
+    void set(size_t i, float bx1, float by1, float bx2, float by2, int l) {
+        x1[i] = bx1;
+        y1[i] = by1;
+        x2[i] = bx2;
+        y2[i] = by2;
+        area[i] = (bx2 - bx1) * (by2 - by1);
+        label[i] = l;
+    }
+};
+
+// The box every block is compared against.
+struct NmsBox {
+    float x1, y1, x2, y2, area;
+    int label;
+};
+
+// True when box j of `b` has IoU > threshold with `a` (and the same label
+// unless agnostic): iou = inter / union, union > 0, computed the same way by
+// every kernel so the result does not depend on the CPU.
+static bool overlap(const NmsBoxes& b, size_t j, const NmsBox& a, float threshold, bool agnostic) {
+    const float iw = std::max(0.f, std::min(a.x2, b.x2[j]) - std::max(a.x1, b.x1[j]));
+    const float ih = std::max(0.f, std::min(a.y2, b.y2[j]) - std::max(a.y1, b.y1[j]));
+    const float inter = iw * ih;
+    const float uni = a.area + b.area[j] - inter;
+    return uni > 0.f && inter / uni > threshold && (agnostic || b.label[j] == a.label);
+}
+
+// Bit k set when box base + k of `b` overlaps `a`, see overlap().
+static uint64_t overlaps(const NmsBoxes& b, size_t base, const NmsBox& a, float threshold, bool agnostic) {
+    uint64_t bits = 0;
+    for (size_t k = 0; k < kNmsBlock; k++) {
+        bits |= static_cast<uint64_t>(overlap(b, base + k, a, threshold, agnostic)) << k;
+    }
+    return bits;
+}
+
+#if defined(MEI_X86_SIMD)
+
+MEI_TARGET_AVX2 static uint64_t overlaps_avx2(const NmsBoxes& b, size_t base, const NmsBox& a, float threshold,
+                                              bool agnostic) {
+    const __m256 ax1 = _mm256_set1_ps(a.x1), ay1 = _mm256_set1_ps(a.y1);
+    const __m256 ax2 = _mm256_set1_ps(a.x2), ay2 = _mm256_set1_ps(a.y2);
+    const __m256 aarea = _mm256_set1_ps(a.area);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 t = _mm256_set1_ps(threshold);
+    const __m256i alabel = _mm256_set1_epi32(a.label);
+    uint64_t bits = 0;
+    for (size_t k = 0; k < kNmsBlock; k += 8) {
+        const size_t j = base + k;
+        const __m256 iw = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(ax2, _mm256_loadu_ps(&b.x2[j])),
+                                                            _mm256_max_ps(ax1, _mm256_loadu_ps(&b.x1[j]))));
+        const __m256 ih = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(ay2, _mm256_loadu_ps(&b.y2[j])),
+                                                            _mm256_max_ps(ay1, _mm256_loadu_ps(&b.y1[j]))));
+        const __m256 inter = _mm256_mul_ps(iw, ih);
+        const __m256 uni = _mm256_sub_ps(_mm256_add_ps(aarea, _mm256_loadu_ps(&b.area[j])), inter);
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(uni, zero, _CMP_GT_OQ),
+                                   _mm256_cmp_ps(_mm256_div_ps(inter, uni), t, _CMP_GT_OQ));
+        if (!agnostic) {
+            const __m256i same = _mm256_cmpeq_epi32(
+                alabel, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&b.label[j])));
+            hit = _mm256_and_ps(hit, _mm256_castsi256_ps(same));
+        }
+        bits |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_ps(hit))) << k;
+    }
+    return bits;
+}
+
+#elif defined(MEI_NEON_SIMD)
+
+static uint64_t overlaps_neon(const NmsBoxes& b, size_t base, const NmsBox& a, float threshold, bool agnostic) {
+    const float32x4_t ax1 = vdupq_n_f32(a.x1), ay1 = vdupq_n_f32(a.y1);
+    const float32x4_t ax2 = vdupq_n_f32(a.x2), ay2 = vdupq_n_f32(a.y2);
+    const float32x4_t aarea = vdupq_n_f32(a.area);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t t = vdupq_n_f32(threshold);
+    const int32x4_t alabel = vdupq_n_s32(a.label);
+    static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t lane_bits = vld1q_u32(kLaneBits);
+    uint64_t bits = 0;
+    for (size_t k = 0; k < kNmsBlock; k += 4) {
+        const size_t j = base + k;
+        const float32x4_t iw =
+            vmaxq_f32(zero, vsubq_f32(vminq_f32(ax2, vld1q_f32(&b.x2[j])), vmaxq_f32(ax1, vld1q_f32(&b.x1[j]))));
+        const float32x4_t ih =
+            vmaxq_f32(zero, vsubq_f32(vminq_f32(ay2, vld1q_f32(&b.y2[j])), vmaxq_f32(ay1, vld1q_f32(&b.y1[j]))));
+        const float32x4_t inter = vmulq_f32(iw, ih);
+        const float32x4_t uni = vsubq_f32(vaddq_f32(aarea, vld1q_f32(&b.area[j])), inter);
+        uint32x4_t hit = vandq_u32(vcgtq_f32(uni, zero), vcgtq_f32(vdivq_f32(inter, uni), t));
+        if (!agnostic) {
+            hit = vandq_u32(hit, vceqq_s32(alabel, vld1q_s32(&b.label[j])));
+        }
+        bits |= static_cast<uint64_t>(vaddvq_u32(vandq_u32(hit, lane_bits))) << k;
+    }
+    return bits;
+}
+
+#endif
+
+using OverlapsFn = uint64_t (*)(const NmsBoxes& b, size_t base, const NmsBox& a, float threshold, bool agnostic);
+
+static OverlapsFn select_overlaps() {
+#if defined(MEI_X86_SIMD)
+    return cpu_has_avx2() ? overlaps_avx2 : overlaps;
+#elif defined(MEI_NEON_SIMD)
+    return overlaps_neon;
+#else
+    return overlaps;
+#endif
+}
+
+static NmsBox nms_box(const NmsBoxes& b, size_t i) {
+    return NmsBox{b.x1[i], b.y1[i], b.x2[i], b.y2[i], b.area[i], b.label[i]};
+}
+
+// Candidates [begin, end) of `sorted`, each against the kept boxes a block at
+// a time until one overlaps it. `kept_boxes` holds the picked boxes so far
+// and has room for `limit`; stops once `limit` are picked.
+static void nms_blocks(const NmsBoxes& sorted, size_t begin, size_t end, float iou_threshold, bool agnostic,
+                       OverlapsFn overlaps_fn, size_t limit, NmsBoxes& kept_boxes, std::vector<int>& picked) {
+    for (size_t i = begin; i < end && picked.size() < limit; i++) {
+        const NmsBox a = nms_box(sorted, i);
+        const size_t num_kept = picked.size();
+        bool suppressed = false;
+        for (size_t base = 0; base < num_kept && !suppressed; base += kNmsBlock) {
+            suppressed = overlaps_fn(kept_boxes, base, a, iou_threshold, agnostic) != 0;
+        }
+        if (!suppressed) {
+            kept_boxes.set(num_kept, a.x1, a.y1, a.x2, a.y2, a.label);
+            picked.push_back(static_cast<int>(i));
+        }
+    }
+}
+
+// Rows of the suppression matrix, computed only for kept boxes and only for
+// the blocks at or after them: bit j of `removed` is set once a kept box
+// overlaps candidate j. Bits for earlier candidates are set too but never
+// read again.
+static void nms_bitmask(const NmsBoxes& sorted, size_t n, float iou_threshold, bool agnostic, OverlapsFn overlaps_fn,
+                        std::vector<int>& picked) {
+    thread_local std::vector<uint64_t> removed;
+    const size_t words = (n + kNmsBlock - 1) / kNmsBlock;
+    removed.assign(words, 0);
+    for (size_t i = 0; i < n; i++) {
+        if ((removed[i / kNmsBlock] >> (i % kNmsBlock)) & 1) continue;
+        picked.push_back(static_cast<int>(i));
+        const NmsBox a = nms_box(sorted, i);
+        for (size_t w = (i + 1) / kNmsBlock; w < words; w++) {
+            if (removed[w] != ~uint64_t(0)) {
+                removed[w] |= overlaps_fn(sorted, w * kNmsBlock, a, iou_threshold, agnostic);
+            }
+        }
+    }
+}
+
+// Uniform grid over the extent of the boxes. Coordinates clamp to the border
+// cells, so the cell of a coordinate never decreases as it grows and two
+// boxes that intersect share at least one cell.
+struct NmsGrid {
+    float x0, y0, scale_x, scale_y;
+    int cols, rows;
+    std::vector<std::vector<int>> cells;
+
+    int col(float x) const { return cell(x - x0, scale_x, cols); }
+    int row(float y) const { return cell(y - y0, scale_y, rows); }
+    static int cell(float offset, float scale, int count) {
+        const float c = offset * scale;
+        if (!(c > 0.f)) return 0;
+        return c < static_cast<float>(count - 1) ? static_cast<int>(c) : count - 1;
+    }
+};
+
+// Cells per axis at most; boxes larger than a cell are listed in each cell
+// they cover.
+static constexpr int kNmsGridMaxCells = 64;
+
+// Cells half the median box size along each axis: a typical box covers
+// three by three cells, each listing only the kept boxes close to it.
+static int nms_grid_cells(std::vector<float>& sizes, float extent) {
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+    const float cell = 0.5f * sizes[sizes.size() / 2];
+    if (!(extent > 0.f) || !(cell > 0.f)) {
+        return 1;
+    }
+    return static_cast<int>(std::min(std::max(extent / cell, 1.f), static_cast<float>(kNmsGridMaxCells)));
+}
+
+// Lays an empty grid over `boxes`. Returns false when the grid does not
+// apply: a box that does not intersect a candidate cannot reach IoU >
+// threshold only for threshold >= 0, and non finite coordinates have no
+// cell.
+static bool nms_grid_init(const DetectionBuffer& boxes, float iou_threshold, NmsGrid& grid) {
+    if (!(iou_threshold >= 0.f)) {
+        return false;
+    }
+    thread_local std::vector<float> widths, heights;
+    const size_t n = boxes.size();
+    float x0 = boxes.x1[0], y0 = boxes.y1[0], x1 = boxes.x2[0], y1 = boxes.y2[0];
+    widths.resize(n);
+    heights.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        if (!std::isfinite(boxes.x1[i]) || !std::isfinite(boxes.y1[i]) || !std::isfinite(boxes.x2[i]) ||
+            !std::isfinite(boxes.y2[i])) {
+            return false;
+        }
+        x0 = std::min(x0, boxes.x1[i]);
+        y0 = std::min(y0, boxes.y1[i]);
+        x1 = std::max(x1, boxes.x2[i]);
+        y1 = std::max(y1, boxes.y2[i]);
+        widths[i] = boxes.x2[i] - boxes.x1[i];
+        heights[i] = boxes.y2[i] - boxes.y1[i];
+    }
+    grid.x0 = x0;
+    grid.y0 = y0;
+    grid.cols = nms_grid_cells(widths, x1 - x0);
+    grid.rows = nms_grid_cells(heights, y1 - y0);
+    grid.scale_x = x1 > x0 ? grid.cols / (x1 - x0) : 0.f;
+    grid.scale_y = y1 > y0 ? grid.rows / (y1 - y0) : 0.f;
+    grid.cells.resize(static_cast<size_t>(grid.cols) * grid.rows);
+    for (std::vector<int>& cell : grid.cells) {
+        cell.clear();
+    }
+    return true;
+}
+
+// nms_blocks() with the kept boxes also listed in the grid cells they cover:
+// each candidate is tested only against the kept boxes listed in its own
+// cells, the survivors are the same.
+static void nms_grid(const NmsBoxes& sorted, size_t begin, size_t end, float iou_threshold, bool agnostic,
+                     size_t limit, NmsGrid& grid, NmsBoxes& kept_boxes, std::vector<int>& picked) {
+    for (size_t i = begin; i < end && picked.size() < limit; i++) {
+        const NmsBox a = nms_box(sorted, i);
+        // A box with x2 < x1 or y2 < y1 covers no cell: it intersects
+        // nothing, so it is kept and suppresses nothing.
+        const int c0 = grid.col(a.x1), c1 = grid.col(a.x2);
+        const int r0 = grid.row(a.y1), r1 = grid.row(a.y2);
+        bool suppressed = false;
+        for (int r = r0; r <= r1 && !suppressed; r++) {
+            for (int c = c0; c <= c1 && !suppressed; c++) {
+                for (int k : grid.cells[static_cast<size_t>(r) * grid.cols + c]) {
+                    if (overlap(kept_boxes, k, a, iou_threshold, agnostic)) {
+                        suppressed = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (suppressed) continue;
+        const int num_kept = static_cast<int>(picked.size());
+        kept_boxes.set(num_kept, a.x1, a.y1, a.x2, a.y2, a.label);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                grid.cells[static_cast<size_t>(r) * grid.cols + c].push_back(num_kept);
+            }
+        }
+        picked.push_back(static_cast<int>(i));
+    }
+}
+
+// Below this many candidates each is tested against the kept boxes; from it
+// on, kept boxes suppress forward through a bitmask of removed candidates.
+static constexpr size_t kNmsBitmaskBoxes = 1024;
+// From this many candidates on NmsMethod::Auto buckets the boxes in a grid.
+static constexpr size_t kNmsGridBoxes = 4096;
+// With max_detections, candidates are ranked this many times the limit at a
+// time (doubling each round), so a full sort only happens when suppression
+// leaves fewer than max_detections survivors.
+static constexpr size_t kNmsRankFactor = 4;
+
+void nms(const DetectionBuffer& boxes, float iou_threshold, bool agnostic, std::vector<Detection>& kept,
+         int max_detections, NmsMethod method) {
+    kept.clear();
+    const size_t n = boxes.size();
+    if (n == 0) {
+        return;
+    }
+    static const OverlapsFn overlaps_fn = select_overlaps();
+    // Per thread scratch, allocated once.
+    thread_local std::vector<int> order, picked;
+    thread_local NmsBoxes sorted, kept_boxes;
+    thread_local NmsGrid grid;
+
+    const size_t limit = max_detections > 0 ? std::min(n, static_cast<size_t>(max_detections)) : n;
+    const bool use_grid = (method == NmsMethod::Grid || (method == NmsMethod::Auto && n >= kNmsGridBoxes)) &&
+                          nms_grid_init(boxes, iou_threshold, grid);
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    sorted.reset(n, n);
+    kept_boxes.reset(0, limit);
+    picked.clear();
+    auto fill_sorted = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const int o = order[i];
+            sorted.set(i, boxes.x1[o], boxes.y1[o], boxes.x2[o], boxes.y2[o], boxes.label[o]);
+        }
+    };
+
+    if (limit == n) {
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return boxes.score[a] > boxes.score[b]; });
+        fill_sorted(0, n);
+        if (use_grid) {
+            nms_grid(sorted, 0, n, iou_threshold, agnostic, limit, grid, kept_boxes, picked);
+        } else if (n < kNmsBitmaskBoxes) {
+            nms_blocks(sorted, 0, n, iou_threshold, agnostic, overlaps_fn, limit, kept_boxes, picked);
+        } else {
+            nms_bitmask(sorted, n, iou_threshold, agnostic, overlaps_fn, picked);
+        }
+    } else {
+        // Rank only the best candidates, suppress among them and rank the
+        // next ones only if fewer than `limit` survived. Ties are broken by
+        // buffer index, the same order the stable sort gives.
+        auto before = [&](int a, int b) {
+            return boxes.score[a] > boxes.score[b] || (boxes.score[a] == boxes.score[b] && a < b);
+        };
+        size_t ranked = 0;
+        for (size_t chunk = kNmsRankFactor * limit; ranked < n && picked.size() < limit; chunk *= 2) {
+            const size_t end = std::min(n, ranked + chunk);
+            if (end < n) {
+                std::nth_element(order.begin() + ranked, order.begin() + end, order.end(), before);
+            }
+            std::sort(order.begin() + ranked, order.begin() + end, before);
+            fill_sorted(ranked, end);
+            if (use_grid) {
+                nms_grid(sorted, ranked, end, iou_threshold, agnostic, limit, grid, kept_boxes, picked);
+            } else {
+                nms_blocks(sorted, ranked, end, iou_threshold, agnostic, overlaps_fn, limit, kept_boxes, picked);
+            }
+            ranked = end;
+        }
+    }
+    kept.reserve(picked.size());
+    for (int i : picked) {
+        kept.push_back({sorted.x1[i], sorted.y1[i], sorted.x2[i], sorted.y2[i], boxes.score[order[i]],
+                        sorted.label[i]});
+    }
+}
+
+static void suppress(const DetectionBuffer& boxes, const ModelSpec& spec, Prediction& result) {
+    nms(boxes, spec.iou_threshold, spec.agnostic, result.detections, spec.max_detections);
+}
+
+static void decode_raw(const ModelSpec& /*spec*/, const std::vector<TensorView>& outputs,
+                       const InputTransform& /*transform*/, Prediction& result) {
+    const float* data = outputs[0].ptr<float>();
+    result.values.assign(data, data + outputs[0].element_count());
+}
+
+static void decode_softmax(const ModelSpec& /*spec*/, const std::vector<TensorView>& outputs,
+                           const InputTransform& /*transform*/, Prediction& result) {
+    const float* data = outputs[0].ptr<float>();
+    const size_t n = static_cast<size_t>(outputs[0].element_count());
+    result.values.resize(n);
+    if (n == 0) return;
+    const float max_val = *std::max_element(data, data + n);
+    float sum = 0.f;
+    for (size_t i = 0; i < n; i++) {
+        result.values[i] = std::exp(data[i] - max_val);
+        sum += result.values[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+        result.values[i] /= sum;
+    }
+}
+
+static void decode_yolov5_output(const ModelSpec& spec, const std::vector<TensorView>& outputs,
+                                 const InputTransform& transform, Prediction& result) {
+    const TensorView& pred = outputs[0];
+    const int length = static_cast<int>(pred.shape[pred.ndim - 1]);
+    if (length <= 5 || (spec.num_classes > 0 && length != spec.num_classes + 5)) {
+        return;
+    }
+    // One per decoding thread (submit() decodes on engine workers), so the
+    // candidate arrays are only allocated the first time.
+    thread_local DetectionBuffer candidates;
+    decode_yolov5(pred.ptr<float>(), pred.element_count() / length, length - 5, spec.score_threshold, transform,
+                  candidates);
+    suppress(candidates, spec, result);
+}
+
+static void decode_ultraface_output(const ModelSpec& spec, const std::vector<TensorView>& outputs,
+                                   const InputTransform& transform, Prediction& result) {
+    const int64_t num_anchors = std::min(outputs[0].element_count() / 2, outputs[1].element_count() / 4);
+    const UltraFaceBoxes form =
+        spec.decoder == DecoderKind::UltraFaceRegression ? UltraFaceBoxes::Regression : UltraFaceBoxes::Corners;
+    thread_local DetectionBuffer boxes;
+    decode_ultraface(outputs[0].ptr<float>(), outputs[1].ptr<float>(), num_anchors, form, spec.score_threshold,
+                     spec.input_width, spec.input_height, transform, boxes);
+    suppress(boxes, spec, result);
+}
+
+Model::DecodeFn select_decoder(const ModelSpec& spec) {
+    switch (spec.decoder) {
+    case DecoderKind::Raw:
+        return decode_raw;
+    case DecoderKind::Softmax:
+        return decode_softmax;
+    case DecoderKind::Yolov5:
+        return decode_yolov5_output;
+    case DecoderKind::UltraFace:
+    case DecoderKind::UltraFaceRegression:
+        return decode_ultraface_output;
+    }
+    return nullptr;
+}
+
+} // namespace mei
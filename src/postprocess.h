@@ -0,0 +1,17 @@
+#ifndef MEI_POSTPROCESS_H_
+#define MEI_POSTPROCESS_H_
+
+#include <vector>
+
+#include "mei/model.h"
+#include "mei/model_spec.h"
+
+namespace mei {
+
+// Decoder for spec.decoder. Outputs handed to it are dense float32, in spec
+// order.
+Model::DecodeFn select_decoder(const ModelSpec& spec);
+
+} // namespace mei
+
+#endif // MEI_POSTPROCESS_H_
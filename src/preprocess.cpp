@@ -0,0 +1,900 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "mei/thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEI_X86_SIMD 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MEI_NEON_SIMD 1
+#endif
+
+namespace mei {
+
+// cv::resize INTER_LINEAR works in 11 bit fixed point per axis, and its 8-bit
+// rows are what the examples normalized; the row pipeline below uses the same
+// sampling and precision. It is not bit-exact with cv::resize, which rounds
+// its weights differently, takes an area path for exact 2x downscales and
+// has its own SIMD vertical pass: expect pixels to differ by up to 1 LSB.
+static constexpr int kCoefBits = 11;
+static constexpr int kCoefScale = 1 << kCoefBits;
+
+// Left/top source index and the fixed point weights of both neighbours for
+// every destination coordinate, cv::resize INTER_LINEAR convention.
+static void linear_coeffs(int src_size, int dst_size, std::vector<int>& index, std::vector<int16_t>& weight) {
+    index.resize(dst_size);
+    weight.resize(2 * static_cast<size_t>(dst_size));
+    const double scale = static_cast<double>(src_size) / dst_size;
+    for (int i = 0; i < dst_size; i++) {
+        float f = static_cast<float>((i + 0.5) * scale - 0.5);
+        int s = static_cast<int>(std::floor(f));
+        f -= s;
+        if (s < 0) {
+            s = 0;
+            f = 0.f;
+        }
+        if (s >= src_size - 1) {
+            s = src_size - 1;
+            f = 0.f;
+        }
+        index[i] = s;
+        weight[2 * i] = static_cast<int16_t>(std::lround((1.f - f) * kCoefScale));
+        weight[2 * i + 1] = static_cast<int16_t>(std::lround(f * kCoefScale));
+    }
+}
+
+// Luma of one pixel with OpenCV's BGR2GRAY fixed point coefficients, so the
+// gray models see what cv::cvtColor produced in the examples.
+template <bool kRgb>
+static inline uint8_t luma(const uint8_t* p) {
+    const int b = p[kRgb ? 2 : 0];
+    const int g = p[1];
+    const int r = p[kRgb ? 0 : 2];
+    return static_cast<uint8_t>((b * 1868 + g * 9617 + r * 4899 + (1 << 13)) >> 14);
+}
+
+// Produces the resized image one row at a time. Each source row is resampled
+// horizontally once and kept while consecutive output rows still blend it, so
+// the source is read once however the output is consumed. Works on any
+// 8-bit plane of interleaved channels (pixels, a Y plane, NV12's UV plane).
+class RowResizer {
+public:
+    RowResizer(const ImageView& src, int dst_width, int dst_height)
+        : RowResizer(src.data, src.width, src.height, src.stride, pixel_channels(src.format), dst_width,
+                     dst_height) {}
+
+    RowResizer(const uint8_t* data, int width, int height, int stride, int channels, int dst_width, int dst_height)
+        : RowResizer(data, width, height, stride, channels, 0, 0, width, height, dst_width, dst_height) {}
+
+    // Resamples the window of crop_width x crop_height pixels at (crop_x,
+    // crop_y) instead. It may reach past the plane: pixels outside read as 0,
+    // as if the plane had been copied into a zero canvas first, and the
+    // window's own edges clamp like cv::resize of that canvas.
+    RowResizer(const uint8_t* data, int width, int height, int stride, int channels, int crop_x, int crop_y,
+               int crop_width, int crop_height, int dst_width, int dst_height)
+        : data_(data), stride_(stride), channels_(channels), dst_width_(dst_width) {
+        std::vector<int> xi, yi;
+        linear_coeffs(crop_width, dst_width, xi, xw_);
+        linear_coeffs(crop_height, dst_height, yi, yw_);
+        x0_.resize(dst_width);
+        x1_.resize(dst_width);
+        for (int x = 0; x < dst_width; x++) {
+            const int next = xi[x] + 1 < crop_width ? xi[x] + 1 : xi[x];
+            x0_[x] = source_index(xi[x] + crop_x, width, xw_[2 * x]) * channels_;
+            x1_[x] = source_index(next + crop_x, width, xw_[2 * x + 1]) * channels_;
+        }
+        y0_.resize(dst_height);
+        y1_.resize(dst_height);
+        for (int y = 0; y < dst_height; y++) {
+            const int next = yi[y] + 1 < crop_height ? yi[y] + 1 : yi[y];
+            y0_[y] = source_index(yi[y] + crop_y, height, yw_[2 * y]);
+            y1_[y] = source_index(next + crop_y, height, yw_[2 * y + 1]);
+        }
+        for (std::vector<int>& h : hrows_) {
+            h.resize(static_cast<size_t>(dst_width) * channels_);
+        }
+    }
+
+    // Emits gray rows from 3 channel BGR (or `rgb`) pixels: the two taps of
+    // each output pixel are reduced to luma before blending, so everything
+    // after them is single channel. Within one level of cv::resize followed
+    // by cvtColor(BGR2GRAY).
+    void to_gray(bool rgb) {
+        gray_ = true;
+        blue_ = rgb ? 2 : 0;
+        out_channels_ = 1;
+        for (std::vector<int>& h : hrows_) {
+            h.resize(dst_width_);
+        }
+    }
+
+    // Writes output row y, dst_width * channels bytes (dst_width for gray
+    // rows).
+    void resize_row(int y, uint8_t* out) {
+        const int sy0 = y0_[y];
+        const int sy1 = y1_[y];
+        const int s0 = hrow(sy0, hrow_y_[0] == sy1 ? 0 : (hrow_y_[1] == sy1 ? 1 : -1));
+        const int s1 = hrow(sy1, s0);
+        const int* h0 = hrows_[s0].data();
+        const int* h1 = hrows_[s1].data();
+        const int b0 = yw_[2 * y];
+        const int b1 = yw_[2 * y + 1];
+        const int n = dst_width_ * out_channels_;
+        for (int i = 0; i < n; i++) {
+            out[i] = static_cast<uint8_t>((h0[i] * b0 + h1[i] * b1 + (1 << (2 * kCoefBits - 1))) >> (2 * kCoefBits));
+        }
+    }
+
+private:
+    // Source sample s clamped into [0, size), with its weight zeroed when it
+    // lies outside: the zero padding costs nothing per pixel.
+    static int source_index(int s, int size, int16_t& weight) {
+        if (s >= 0 && s < size) {
+            return s;
+        }
+        weight = 0;
+        return s < 0 ? 0 : size - 1;
+    }
+
+    int gray(const uint8_t* p) const { return blue_ == 0 ? luma<false>(p) : luma<true>(p); }
+
+    // Slot holding source row sy resampled horizontally, computed into the
+    // slot other than `keep` on a miss.
+    int hrow(int sy, int keep) {
+        for (int s = 0; s < 2; s++) {
+            if (hrow_y_[s] == sy) return s;
+        }
+        const int s = keep == 0 ? 1 : 0;
+        const uint8_t* row = data_ + static_cast<size_t>(sy) * stride_;
+        int* out = hrows_[s].data();
+        if (gray_) {
+            for (int x = 0; x < dst_width_; x++) {
+                out[x] = gray(row + x0_[x]) * xw_[2 * x] + gray(row + x1_[x]) * xw_[2 * x + 1];
+            }
+        } else if (channels_ == 3) {
+            for (int x = 0; x < dst_width_; x++) {
+                const int a0 = xw_[2 * x], a1 = xw_[2 * x + 1];
+                const uint8_t* p0 = row + x0_[x];
+                const uint8_t* p1 = row + x1_[x];
+                out[3 * x] = p0[0] * a0 + p1[0] * a1;
+                out[3 * x + 1] = p0[1] * a0 + p1[1] * a1;
+                out[3 * x + 2] = p0[2] * a0 + p1[2] * a1;
+            }
+        } else if (channels_ == 1) {
+            for (int x = 0; x < dst_width_; x++) {
+                out[x] = row[x0_[x]] * xw_[2 * x] + row[x1_[x]] * xw_[2 * x + 1];
+            }
+        } else {
+            for (int x = 0; x < dst_width_; x++) {
+                const int a0 = xw_[2 * x], a1 = xw_[2 * x + 1];
+                for (int c = 0; c < channels_; c++) {
+                    out[x * channels_ + c] = row[x0_[x] + c] * a0 + row[x1_[x] + c] * a1;
+                }
+            }
+        }
+        hrow_y_[s] = sy;
+        return s;
+    }
+
+    const uint8_t* const data_;
+    const int stride_;
+    const int channels_;
+    const int dst_width_;
+    int out_channels_ = channels_;
+    bool gray_ = false;
+    // Index of blue in a source pixel, for to_gray().
+    int blue_ = 0;
+    // Byte offsets of the left / right neighbour in a source row.
+    std::vector<int> x0_, x1_;
+    std::vector<int16_t> xw_;
+    // Source rows blended into each output row.
+    std::vector<int> y0_, y1_;
+    std::vector<int16_t> yw_;
+    std::vector<int> hrows_[2];
+    int hrow_y_[2] = {-1, -1};
+};
+
+// BT.601 limited range YUV -> BGR with the fixed point constants of OpenCV's
+// COLOR_YUV2BGR_NV12 / _I420.
+static constexpr int kYuvShift = 20;
+static constexpr int kYuvCy = 1220542;
+static constexpr int kYuvCub = 2116026;
+static constexpr int kYuvCug = -409993;
+static constexpr int kYuvCvg = -852492;
+static constexpr int kYuvCvr = 1673527;
+
+static inline uint8_t clamp_u8(int v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// RowResizer for 4:2:0 frames, producing 8-bit BGR rows. Luma and chroma are
+// resampled in their own planes to the output size and converted there, so
+// no full resolution BGR frame is ever formed and only output pixels pay for
+// the color conversion.
+class YuvRowResizer {
+public:
+    YuvRowResizer(const YuvImageView& src, int dst_width, int dst_height)
+        : dst_width_(dst_width), interleaved_(src.uv_step == 2), v_first_(interleaved_ && src.v < src.u),
+          luma_(src.y, src.width, src.height, src.y_stride, 1, dst_width, dst_height),
+          chroma_(v_first_ ? src.v : src.u, (src.width + 1) / 2, (src.height + 1) / 2, src.uv_stride,
+                  interleaved_ ? 2 : 1, dst_width, dst_height),
+          y_(dst_width), uv_(2 * static_cast<size_t>(dst_width)) {
+        if (!interleaved_) {
+            v_plane_.reset(new RowResizer(src.v, (src.width + 1) / 2, (src.height + 1) / 2, src.uv_stride, 1,
+                                          dst_width, dst_height));
+        }
+    }
+
+    void resize_row(int y, uint8_t* out) {
+        luma_.resize_row(y, y_.data());
+        chroma_.resize_row(y, uv_.data());
+        // Separate planes: U in the first half, V in the second.
+        if (v_plane_) {
+            v_plane_->resize_row(y, uv_.data() + dst_width_);
+        }
+        for (int x = 0; x < dst_width_; x++) {
+            int u, v;
+            if (interleaved_) {
+                u = uv_[2 * x + (v_first_ ? 1 : 0)];
+                v = uv_[2 * x + (v_first_ ? 0 : 1)];
+            } else {
+                u = uv_[x];
+                v = uv_[dst_width_ + x];
+            }
+            u -= 128;
+            v -= 128;
+            const int yy = std::max(0, y_[x] - 16) * kYuvCy;
+            const int round = 1 << (kYuvShift - 1);
+            out[3 * x] = clamp_u8((yy + round + kYuvCub * u) >> kYuvShift);
+            out[3 * x + 1] = clamp_u8((yy + round + kYuvCvg * v + kYuvCug * u) >> kYuvShift);
+            out[3 * x + 2] = clamp_u8((yy + round + kYuvCvr * v) >> kYuvShift);
+        }
+    }
+
+private:
+    const int dst_width_;
+    const bool interleaved_;
+    const bool v_first_;
+    RowResizer luma_;
+    RowResizer chroma_;
+    // I420 only, chroma_ resamples U.
+    std::unique_ptr<RowResizer> v_plane_;
+    std::vector<uint8_t> y_;
+    std::vector<uint8_t> uv_;
+};
+
+void yuv_to_bgr(const YuvImageView& src, std::vector<uint8_t>& bgr) {
+    bgr.resize(static_cast<size_t>(src.width) * src.height * 3);
+    YuvRowResizer resizer(src, src.width, src.height);
+    for (int y = 0; y < src.height; y++) {
+        resizer.resize_row(y, bgr.data() + static_cast<size_t>(y) * src.width * 3);
+    }
+}
+
+// How a kernel produces its values: computing (v - mean) * norm, looking the
+// same float up in params.lut, or looking the quantized byte up in
+// params.qlut (UInt8 / Int8 inputs).
+enum class Output { Compute, Table, Quantized };
+
+// One instance per (source channels, network channels, R/B swap, layout,
+// output), so the inner loop has no per pixel branching. For 3 -> 1 channel
+// kernels kSwap means the source is RGB. Converts pixels [begin, end) of one
+// row; the SIMD kernels finish their rows with it.
+template <int kSrcChannels, int kDstChannels, bool kSwap, bool kPlanar, Output kOutput>
+static inline void normalize_pixels(const uint8_t* src, int begin, int end, const Model::NormalizeParams& params,
+                                    void* dst, size_t plane) {
+    using T = typename std::conditional<kOutput == Output::Quantized, uint8_t, float>::type;
+    T* out = static_cast<T*>(dst);
+    for (int x = begin; x < end; x++) {
+        const uint8_t* p = src + x * kSrcChannels;
+        int v[3];
+        if constexpr (kDstChannels == 3 && kSrcChannels == 3) {
+            v[0] = p[kSwap ? 2 : 0];
+            v[1] = p[1];
+            v[2] = p[kSwap ? 0 : 2];
+        } else if constexpr (kDstChannels == 3) {
+            v[0] = v[1] = v[2] = p[0];
+        } else if constexpr (kSrcChannels == 3) {
+            v[0] = luma<kSwap>(p);
+        } else {
+            v[0] = p[0];
+        }
+        for (int c = 0; c < kDstChannels; c++) {
+            T value;
+            if constexpr (kOutput == Output::Quantized) {
+                value = params.qlut[c][v[c]];
+            } else if constexpr (kOutput == Output::Table) {
+                value = params.lut[c][v[c]];
+            } else {
+                value = (static_cast<float>(v[c]) - params.mean[c]) * params.norm[c];
+            }
+            if constexpr (kPlanar) {
+                out[c * plane + x] = value;
+            } else {
+                out[static_cast<size_t>(x) * kDstChannels + c] = value;
+            }
+        }
+    }
+}
+
+template <int kSrcChannels, int kDstChannels, bool kSwap, bool kPlanar, Output kOutput>
+static void normalize_row(const uint8_t* src, int width, const Model::NormalizeParams& params, void* dst,
+                          size_t plane) {
+    normalize_pixels<kSrcChannels, kDstChannels, kSwap, kPlanar, kOutput>(src, 0, width, params, dst, plane);
+}
+
+// 16 pixels per iteration for the planar 3 -> 3 and 1 -> 1 cases, every
+// model with a planar input. (v - mean) * norm as in the scalar kernel, so
+// both give the same floats.
+#if defined(MEI_X86_SIMD)
+
+#define MEI_TARGET_AVX2 __attribute__((target("avx2")))
+
+MEI_TARGET_AVX2 static inline void store16_avx2(float* out, __m128i v, __m256 mean, __m256 norm) {
+    const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+    const __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+    _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_sub_ps(lo, mean), norm));
+    _mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_sub_ps(hi, mean), norm));
+}
+
+template <bool kSwap>
+MEI_TARGET_AVX2 static void normalize_row_3_avx2(const uint8_t* src, int width,
+                                                 const Model::NormalizeParams& params, void* out, size_t plane) {
+    float* dst = static_cast<float*>(out);
+    // Deinterleave 48 bytes into 16 bytes per channel: each channel gathers
+    // its bytes from the three loads and ORs them together.
+    const __m128i a0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b0 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i c0 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i a1 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i c1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i a2 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i c2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    __m256 m[3], n[3];
+    for (int c = 0; c < 3; c++) {
+        m[c] = _mm256_set1_ps(params.mean[c]);
+        n[c] = _mm256_set1_ps(params.norm[c]);
+    }
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* p = src + 3 * x;
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        const __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+        const __m128i ch0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(va, a0), _mm_shuffle_epi8(vb, b0)),
+                                         _mm_shuffle_epi8(vc, c0));
+        const __m128i ch1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(va, a1), _mm_shuffle_epi8(vb, b1)),
+                                         _mm_shuffle_epi8(vc, c1));
+        const __m128i ch2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(va, a2), _mm_shuffle_epi8(vb, b2)),
+                                         _mm_shuffle_epi8(vc, c2));
+        store16_avx2(dst + x, kSwap ? ch2 : ch0, m[0], n[0]);
+        store16_avx2(dst + plane + x, ch1, m[1], n[1]);
+        store16_avx2(dst + 2 * plane + x, kSwap ? ch0 : ch2, m[2], n[2]);
+    }
+    normalize_pixels<3, 3, kSwap, true, Output::Compute>(src, x, width, params, dst, plane);
+}
+
+MEI_TARGET_AVX2 static void normalize_row_1_avx2(const uint8_t* src, int width,
+                                                 const Model::NormalizeParams& params, void* out, size_t plane) {
+    float* dst = static_cast<float*>(out);
+    const __m256 m = _mm256_set1_ps(params.mean[0]);
+    const __m256 n = _mm256_set1_ps(params.norm[0]);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        store16_avx2(dst + x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)), m, n);
+    }
+    normalize_pixels<1, 1, false, true, Output::Compute>(src, x, width, params, dst, plane);
+}
+
+static bool cpu_has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+#elif defined(MEI_NEON_SIMD)
+
+static inline void store16_neon(float* out, uint8x16_t v, float32x4_t mean, float32x4_t norm) {
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+    vst1q_f32(out, vmulq_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), mean), norm));
+    vst1q_f32(out + 4, vmulq_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), mean), norm));
+    vst1q_f32(out + 8, vmulq_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), mean), norm));
+    vst1q_f32(out + 12, vmulq_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), mean), norm));
+}
+
+template <bool kSwap>
+static void normalize_row_3_neon(const uint8_t* src, int width, const Model::NormalizeParams& params,
+                                 void* out, size_t plane) {
+    float* dst = static_cast<float*>(out);
+    float32x4_t m[3], n[3];
+    for (int c = 0; c < 3; c++) {
+        m[c] = vdupq_n_f32(params.mean[c]);
+        n[c] = vdupq_n_f32(params.norm[c]);
+    }
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x3_t px = vld3q_u8(src + 3 * x);
+        store16_neon(dst + x, px.val[kSwap ? 2 : 0], m[0], n[0]);
+        store16_neon(dst + plane + x, px.val[1], m[1], n[1]);
+        store16_neon(dst + 2 * plane + x, px.val[kSwap ? 0 : 2], m[2], n[2]);
+    }
+    normalize_pixels<3, 3, kSwap, true, Output::Compute>(src, x, width, params, dst, plane);
+}
+
+static void normalize_row_1_neon(const uint8_t* src, int width, const Model::NormalizeParams& params,
+                                 void* out, size_t plane) {
+    float* dst = static_cast<float*>(out);
+    const float32x4_t m = vdupq_n_f32(params.mean[0]);
+    const float32x4_t n = vdupq_n_f32(params.norm[0]);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        store16_neon(dst + x, vld1q_u8(src + x), m, n);
+    }
+    normalize_pixels<1, 1, false, true, Output::Compute>(src, x, width, params, dst, plane);
+}
+
+#endif
+
+// SIMD kernel for the planar cases that have one, nullptr otherwise.
+static Model::NormalizeFn select_simd(PixelFormat src, PixelFormat dst) {
+#if defined(MEI_X86_SIMD)
+    if (!cpu_has_avx2()) return nullptr;
+    if (src == PixelFormat::Gray && dst == PixelFormat::Gray) return normalize_row_1_avx2;
+    if (src != PixelFormat::Gray && dst != PixelFormat::Gray) {
+        return src != dst ? normalize_row_3_avx2<true> : normalize_row_3_avx2<false>;
+    }
+#elif defined(MEI_NEON_SIMD)
+    if (src == PixelFormat::Gray && dst == PixelFormat::Gray) return normalize_row_1_neon;
+    if (src != PixelFormat::Gray && dst != PixelFormat::Gray) {
+        return src != dst ? normalize_row_3_neon<true> : normalize_row_3_neon<false>;
+    }
+#else
+    (void)src;
+    (void)dst;
+#endif
+    return nullptr;
+}
+
+template <bool kPlanar, Output kOutput>
+static Model::NormalizeFn select_for_layout(PixelFormat src, PixelFormat dst) {
+    if (dst == PixelFormat::Gray) {
+        if (src == PixelFormat::Gray) return normalize_row<1, 1, false, kPlanar, kOutput>;
+        if (src == PixelFormat::RGB) return normalize_row<3, 1, true, kPlanar, kOutput>;
+        return normalize_row<3, 1, false, kPlanar, kOutput>;
+    }
+    if (src == PixelFormat::Gray) return normalize_row<1, 3, false, kPlanar, kOutput>;
+    if (src != dst) return normalize_row<3, 3, true, kPlanar, kOutput>;
+    return normalize_row<3, 3, false, kPlanar, kOutput>;
+}
+
+// Computes (v - mean) * norm, with SIMD where there is a kernel for the case.
+static Model::NormalizeFn arithmetic_kernel(PixelFormat src, PixelFormat dst, bool planar) {
+    if (!planar) {
+        return select_for_layout<false, Output::Compute>(src, dst);
+    }
+    if (Model::NormalizeFn simd = select_simd(src, dst)) {
+        return simd;
+    }
+    return select_for_layout<true, Output::Compute>(src, dst);
+}
+
+static Model::NormalizeFn lut_kernel(PixelFormat src, PixelFormat dst, bool planar) {
+    return planar ? select_for_layout<true, Output::Table>(src, dst)
+                  : select_for_layout<false, Output::Table>(src, dst);
+}
+
+// Best of a few runs over a synthetic row block, in seconds.
+static double time_kernel(Model::NormalizeFn normalize, const uint8_t* src, int width, int rows,
+                          const Model::NormalizeParams& params, float* dst) {
+    double best = 1e30;
+    for (int run = 0; run < 5; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int y = 0; y < rows; y++) {
+            normalize(src, width, params, dst, static_cast<size_t>(width));
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// Which of the two kernels is faster depends on the CPU (gather cost, SIMD
+// width, cache) and on the case, so every (source, network format, layout) is
+// timed once per process, the first time a kernel is selected. Both kinds give
+// the same floats, the choice only changes the speed.
+static bool prefer_lut(PixelFormat src, PixelFormat dst, bool planar) {
+    static const std::vector<bool> faster = [] {
+        const int width = 640;
+        const int rows = 16;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * 3);
+        for (size_t i = 0; i < pixels.size(); i++) {
+            pixels[i] = static_cast<uint8_t>(i * 131 + 7);
+        }
+        std::vector<float> out(static_cast<size_t>(width) * 3);
+        const float mean[3] = {123.675f, 116.28f, 103.53f};
+        const float norm[3] = {1 / 58.395f, 1 / 57.12f, 1 / 57.375f};
+        Model::NormalizeParams params;
+        make_normalize_params(mean, norm, 3, params);
+
+        std::vector<bool> result(kPixelFormatCount * kPixelFormatCount * 2);
+        for (int s = 0; s < kPixelFormatCount; s++) {
+            for (int d = 0; d < kPixelFormatCount; d++) {
+                for (int planar = 0; planar < 2; planar++) {
+                    const PixelFormat sf = static_cast<PixelFormat>(s);
+                    const PixelFormat df = static_cast<PixelFormat>(d);
+                    const double arithmetic = time_kernel(arithmetic_kernel(sf, df, planar), pixels.data(), width,
+                                                          rows, params, out.data());
+                    const double lut =
+                        time_kernel(lut_kernel(sf, df, planar), pixels.data(), width, rows, params, out.data());
+                    result[(s * kPixelFormatCount + d) * 2 + planar] = lut < arithmetic;
+                }
+            }
+        }
+        return result;
+    }();
+    return faster[(static_cast<int>(src) * kPixelFormatCount + static_cast<int>(dst)) * 2 + (planar ? 1 : 0)];
+}
+
+static bool is_quantized(DataType dtype) {
+    return dtype == DataType::UInt8 || dtype == DataType::Int8;
+}
+
+Model::NormalizeFn select_normalize(PixelFormat src, PixelFormat dst, Layout layout, DataType dtype) {
+    const bool planar = layout != Layout::NHWC;
+    if (is_quantized(dtype)) {
+        // A byte lookup per value, nothing cheaper to compare it with.
+        return planar ? select_for_layout<true, Output::Quantized>(src, dst)
+                      : select_for_layout<false, Output::Quantized>(src, dst);
+    }
+    return prefer_lut(src, dst, planar) ? lut_kernel(src, dst, planar) : arithmetic_kernel(src, dst, planar);
+}
+
+// round(value / scale) + zero_point, saturated to the type's range, as the
+// byte stored in the tensor (Int8 in two's complement).
+static uint8_t quantize(float value, DataType dtype, const Quantization& quant) {
+    const int lo = dtype == DataType::Int8 ? -128 : 0;
+    const int hi = dtype == DataType::Int8 ? 127 : 255;
+    const float q = std::round(value / quant.scale) + static_cast<float>(quant.zero_point);
+    return static_cast<uint8_t>(static_cast<int>(std::min<float>(std::max<float>(q, lo), hi)) & 0xff);
+}
+
+void make_normalize_params(const float* mean, const float* norm, int channels, Model::NormalizeParams& params,
+                           DataType dtype, const Quantization& quant) {
+    params.dtype = dtype;
+    params.quant = quant;
+    for (int c = 0; c < 3; c++) {
+        params.mean[c] = c < channels ? mean[c] : 0.f;
+        params.norm[c] = c < channels ? norm[c] : 1.f;
+        for (int v = 0; v < 256; v++) {
+            params.lut[c][v] = (static_cast<float>(v) - params.mean[c]) * params.norm[c];
+            params.qlut[c][v] = is_quantized(dtype) ? quantize(params.lut[c][v], dtype, quant) : 0;
+        }
+    }
+}
+
+// Width, height, channel plane pitch and row pitch (in elements) of a 4-D
+// NCHW / NHWC view of `dtype` (float32, or 8-bit for quantized inputs), e.g.
+// an ncnn input Mat padded to its cstep.
+static bool image_geometry(const TensorView& dst, int dst_channels, DataType dtype, int& width, int& height,
+                           size_t& plane, size_t& row) {
+    if (!dst.data || dst.ndim != 4 || dst.dtype != dtype || (dtype != DataType::Float32 && !is_quantized(dtype))) {
+        return false;
+    }
+    if (dst.layout == Layout::NHWC) {
+        if (dst.shape[3] != dst_channels || dst.strides[3] != 1 || dst.strides[2] != dst_channels) {
+            return false;
+        }
+        height = static_cast<int>(dst.shape[1]);
+        width = static_cast<int>(dst.shape[2]);
+        plane = 1;
+        row = static_cast<size_t>(dst.strides[1]);
+        return true;
+    }
+    if ((dst.layout != Layout::NCHW && dst.layout != Layout::Any) || dst.shape[1] != dst_channels ||
+        dst.strides[3] != 1) {
+        return false;
+    }
+    height = static_cast<int>(dst.shape[2]);
+    width = static_cast<int>(dst.shape[3]);
+    plane = static_cast<size_t>(dst.strides[1]);
+    row = static_cast<size_t>(dst.strides[2]);
+    return true;
+}
+
+// Outputs below this many pixels are done on the calling thread, waking the
+// pool costs more than it saves. Tiles are at least kMinTileRows rows.
+static constexpr int kParallelPixels = 160 * 160;
+static constexpr int kMinTileRows = 16;
+
+// Runs rows(y0, y1) over row tiles covering [0, height), in parallel on
+// ThreadPool::shared() for large outputs, on at most `max_threads` threads
+// counting the caller. Every tile resamples with its own RowResizer and an
+// output row is computed the same way whichever tile it lands in, so the
+// result is the serial one bit for bit.
+template <typename Fn>
+static void for_row_tiles(int width, int height, int max_threads, const Fn& rows) {
+    ThreadPool& pool = ThreadPool::shared();
+    const int tiles = static_cast<int64_t>(width) * height < kParallelPixels
+                          ? 1
+                          : std::min({max_threads, pool.size(), height / kMinTileRows});
+    if (tiles <= 1) {
+        rows(0, height);
+        return;
+    }
+    pool.parallel_for(tiles, [&](int t) {
+        rows(static_cast<int>(static_cast<int64_t>(height) * t / tiles),
+             static_cast<int>(static_cast<int64_t>(height) * (t + 1) / tiles));
+    });
+}
+
+PixelFormat kernel_format(PixelFormat src, int dst_channels) {
+    return dst_channels == 1 ? PixelFormat::Gray : src;
+}
+
+// A window of an image for the pipelines, possibly reaching past its edges.
+struct ImageCrop {
+    ImageView image;
+    int x, y, width, height;
+};
+
+// Row source of the pipelines below and the format of its rows: 8-bit pixels
+// are resampled as they are (reduced to luma for gray outputs), 4:2:0 frames
+// come out as BGR rows.
+static PixelFormat row_format(const ImageView& src, int dst_channels) {
+    return kernel_format(src.format, dst_channels);
+}
+
+static PixelFormat row_format(const ImageCrop& src, int dst_channels) {
+    return kernel_format(src.image.format, dst_channels);
+}
+
+static PixelFormat row_format(const YuvImageView&, int) {
+    return PixelFormat::BGR;
+}
+
+static RowResizer row_resizer(const ImageCrop& src, int dst_width, int dst_height, int dst_channels) {
+    const ImageView& image = src.image;
+    RowResizer resizer(image.data, image.width, image.height, image.stride, pixel_channels(image.format), src.x,
+                       src.y, src.width, src.height, dst_width, dst_height);
+    if (row_format(src, dst_channels) == PixelFormat::Gray && image.format != PixelFormat::Gray) {
+        resizer.to_gray(image.format == PixelFormat::RGB);
+    }
+    return resizer;
+}
+
+static RowResizer row_resizer(const ImageView& src, int dst_width, int dst_height, int dst_channels) {
+    return row_resizer(ImageCrop{src, 0, 0, src.width, src.height}, dst_width, dst_height, dst_channels);
+}
+
+static YuvRowResizer row_resizer(const YuvImageView& src, int dst_width, int dst_height, int) {
+    return YuvRowResizer(src, dst_width, dst_height);
+}
+
+template <typename Image>
+static bool resize_image(const Image& src, Model::NormalizeFn normalize, int dst_channels,
+                         const Model::NormalizeParams& params, const TensorView& dst, int max_threads) {
+    int width, height;
+    size_t plane, row;
+    if (!image_geometry(dst, dst_channels, params.dtype, width, height, plane, row)) {
+        return false;
+    }
+    uint8_t* out = static_cast<uint8_t*>(dst.data);
+    const size_t element = dtype_size(dst.dtype);
+    for_row_tiles(width, height, max_threads, [&](int y0, int y1) {
+        // The 8-bit row stays in L1 between the two stages.
+        auto resizer = row_resizer(src, width, height, dst_channels);
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * pixel_channels(row_format(src, dst_channels)));
+        for (int y = y0; y < y1; y++) {
+            resizer.resize_row(y, pixels.data());
+            normalize(pixels.data(), width, params, out + y * row * element, plane);
+        }
+    });
+    return true;
+}
+
+bool resize_normalize(const ImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                      const Model::NormalizeParams& params, const TensorView& dst, int max_threads) {
+    return resize_image(src, normalize, dst_channels, params, dst, max_threads);
+}
+
+bool resize_normalize(const YuvImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                      const Model::NormalizeParams& params, const TensorView& dst, int max_threads) {
+    return resize_image(src, normalize, dst_channels, params, dst, max_threads);
+}
+
+bool crop_normalize(const ImageView& src, int x, int y, int width, int height, Model::NormalizeFn normalize,
+                    int dst_channels, const Model::NormalizeParams& params, const TensorView& dst,
+                    InputTransform& transform, int max_threads) {
+    if (src.empty() || width <= 0 || height <= 0 || dst.ndim != 4) {
+        return false;
+    }
+    const ImageCrop crop = {src, x, y, width, height};
+    if (!resize_image(crop, normalize, dst_channels, params, dst, max_threads)) {
+        return false;
+    }
+    const bool nhwc = dst.layout == Layout::NHWC;
+    transform.scale_x = static_cast<float>(dst.shape[nhwc ? 2 : 3]) / width;
+    transform.scale_y = static_cast<float>(dst.shape[nhwc ? 1 : 2]) / height;
+    transform.dx = -x * transform.scale_x;
+    transform.dy = -y * transform.scale_y;
+    return true;
+}
+
+// Sets `count` pixels starting at `out` to `values` (one per channel).
+template <typename T>
+static void fill_pixels(T* out, int count, int channels, bool planar, size_t plane, const T* values) {
+    if (planar) {
+        for (int c = 0; c < channels; c++) {
+            std::fill(out + c * plane, out + c * plane + count, values[c]);
+        }
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            out[i * channels + c] = values[c];
+        }
+    }
+}
+
+template <typename T, typename Image>
+static void letterbox_rows(const Image& src, Model::NormalizeFn normalize, int channels,
+                           const Model::NormalizeParams& params, const T* pad, int new_w, int new_h, int dw, int dh,
+                           bool planar, const TensorView& dst, int width, int height, size_t plane, size_t row,
+                           int max_threads) {
+    // Where pixel x of a row starts, relative to the row.
+    const size_t pixel = planar ? 1 : static_cast<size_t>(channels);
+    T* out = dst.ptr<T>();
+    for_row_tiles(width, height, max_threads, [&](int y0, int y1) {
+        auto resizer = row_resizer(src, new_w, new_h, channels);
+        std::vector<uint8_t> pixels(static_cast<size_t>(new_w) * pixel_channels(row_format(src, channels)));
+        for (int y = y0; y < y1; y++) {
+            T* line = out + y * row;
+            if (y < dh || y >= dh + new_h) {
+                fill_pixels(line, width, channels, planar, plane, pad);
+                continue;
+            }
+            resizer.resize_row(y - dh, pixels.data());
+            fill_pixels(line, dw, channels, planar, plane, pad);
+            normalize(pixels.data(), new_w, params, line + dw * pixel, plane);
+            fill_pixels(line + (dw + new_w) * pixel, width - dw - new_w, channels, planar, plane, pad);
+        }
+    });
+}
+
+template <typename Image>
+static bool letterbox_image(const Image& src, Model::NormalizeFn normalize, int dst_channels,
+                            const Model::NormalizeParams& params, float pad_value, const TensorView& dst,
+                            InputTransform& transform, int max_threads) {
+    int width, height;
+    size_t plane, row;
+    if (!image_geometry(dst, dst_channels, params.dtype, width, height, plane, row)) {
+        return false;
+    }
+    const float r = std::min(static_cast<float>(height) / src.height, static_cast<float>(width) / src.width);
+    const int new_w = std::max(1, static_cast<int>(std::round(src.width * r)));
+    const int new_h = std::max(1, static_cast<int>(std::round(src.height * r)));
+    const int dw = (width - new_w) / 2;
+    const int dh = (height - new_h) / 2;
+    transform.scale_x = transform.scale_y = r;
+    transform.dx = static_cast<float>(dw);
+    transform.dy = static_cast<float>(dh);
+
+    float pad[3];
+    uint8_t quantized_pad[3];
+    for (int c = 0; c < dst_channels; c++) {
+        pad[c] = (pad_value - params.mean[c]) * params.norm[c];
+        quantized_pad[c] = is_quantized(params.dtype) ? quantize(pad[c], params.dtype, params.quant) : 0;
+    }
+    const bool planar = dst.layout != Layout::NHWC;
+    if (is_quantized(params.dtype)) {
+        letterbox_rows<uint8_t>(src, normalize, dst_channels, params, quantized_pad, new_w, new_h, dw, dh, planar,
+                                dst, width, height, plane, row, max_threads);
+    } else {
+        letterbox_rows<float>(src, normalize, dst_channels, params, pad, new_w, new_h, dw, dh, planar, dst, width,
+                              height, plane, row, max_threads);
+    }
+    return true;
+}
+
+bool letterbox_normalize(const ImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                         const Model::NormalizeParams& params, float pad_value, const TensorView& dst,
+                         InputTransform& transform, int max_threads) {
+    return letterbox_image(src, normalize, dst_channels, params, pad_value, dst, transform, max_threads);
+}
+
+bool letterbox_normalize(const YuvImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                         const Model::NormalizeParams& params, float pad_value, const TensorView& dst,
+                         InputTransform& transform, int max_threads) {
+    return letterbox_image(src, normalize, dst_channels, params, pad_value, dst, transform, max_threads);
+}
+
+// The public entry points: kernel and tables for this one call. They have no
+// engine grant to size from and tile over the whole shared pool.
+template <typename Image>
+static bool letterbox_public(const Image& src, PixelFormat dst_format, const float* mean, const float* norm,
+                             float pad_value, const TensorView& dst, InputTransform& transform) {
+    if (src.empty()) {
+        return false;
+    }
+    const Layout layout = dst.layout == Layout::NHWC ? Layout::NHWC : Layout::NCHW;
+    const int channels = pixel_channels(dst_format);
+    Model::NormalizeParams params;
+    make_normalize_params(mean, norm, channels, params, dst.dtype, dst.quant);
+    return letterbox_image(src, select_normalize(row_format(src, channels), dst_format, layout, dst.dtype), channels,
+                           params, pad_value, dst, transform, ThreadPool::shared().size());
+}
+
+template <typename Image>
+static bool resize_public(const Image& src, PixelFormat dst_format, const float* mean, const float* norm,
+                          const TensorView& dst) {
+    if (src.empty()) {
+        return false;
+    }
+    const Layout layout = dst.layout == Layout::NHWC ? Layout::NHWC : Layout::NCHW;
+    const int channels = pixel_channels(dst_format);
+    Model::NormalizeParams params;
+    make_normalize_params(mean, norm, channels, params, dst.dtype, dst.quant);
+    return resize_image(src, select_normalize(row_format(src, channels), dst_format, layout, dst.dtype), channels,
+                        params, dst, ThreadPool::shared().size());
+}
+
+bool crop_normalize(const ImageView& src, int x, int y, int width, int height, PixelFormat dst_format,
+                    const float* mean, const float* norm, const TensorView& dst, InputTransform& transform) {
+    const Layout layout = dst.layout == Layout::NHWC ? Layout::NHWC : Layout::NCHW;
+    const int channels = pixel_channels(dst_format);
+    Model::NormalizeParams params;
+    make_normalize_params(mean, norm, channels, params, dst.dtype, dst.quant);
+    return crop_normalize(src, x, y, width, height,
+                          select_normalize(kernel_format(src.format, channels), dst_format, layout, dst.dtype),
+                          channels, params, dst, transform, ThreadPool::shared().size());
+}
+
+bool letterbox_normalize(const ImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                         float pad_value, const TensorView& dst, InputTransform& transform) {
+    return letterbox_public(src, dst_format, mean, norm, pad_value, dst, transform);
+}
+
+bool letterbox_normalize(const YuvImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                         float pad_value, const TensorView& dst, InputTransform& transform) {
+    return letterbox_public(src, dst_format, mean, norm, pad_value, dst, transform);
+}
+
+bool resize_normalize(const ImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                      const TensorView& dst) {
+    return resize_public(src, dst_format, mean, norm, dst);
+}
+
+bool resize_normalize(const YuvImageView& src, PixelFormat dst_format, const float* mean, const float* norm,
+                      const TensorView& dst) {
+    return resize_public(src, dst_format, mean, norm, dst);
+}
+
+void resize_normalize(const ImageView& src, int dst_width, int dst_height, PixelFormat dst_format,
+                      const float* mean, const float* norm, Layout layout, float* dst) {
+    const int64_t c = pixel_channels(dst_format);
+    const std::vector<int64_t> shape = layout == Layout::NHWC ? std::vector<int64_t>{1, dst_height, dst_width, c}
+                                                              : std::vector<int64_t>{1, c, dst_height, dst_width};
+    resize_normalize(src, dst_format, mean, norm, TensorView::dense(dst, shape, DataType::Float32, layout));
+}
+
+InputTransform letterbox_normalize(const ImageView& src, int dst_width, int dst_height, PixelFormat dst_format,
+                                   const float* mean, const float* norm, float pad_value, Layout layout, float* dst) {
+    const int64_t c = pixel_channels(dst_format);
+    const std::vector<int64_t> shape = layout == Layout::NHWC ? std::vector<int64_t>{1, dst_height, dst_width, c}
+                                                              : std::vector<int64_t>{1, c, dst_height, dst_width};
+    InputTransform transform;
+    letterbox_normalize(src, dst_format, mean, norm, pad_value,
+                        TensorView::dense(dst, shape, DataType::Float32, layout), transform);
+    return transform;
+}
+
+} // namespace mei
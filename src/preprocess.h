@@ -0,0 +1,61 @@
+#ifndef MEI_PREPROCESS_H_
+#define MEI_PREPROCESS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mei/image.h"
+#include "mei/image_preprocess.h"
+#include "mei/model.h"
+#include "mei/tensor_view.h"
+
+namespace mei {
+
+// Row kernel converting `src` pixels to `dst` channel order, normalizing and
+// writing planes (NCHW) or interleaved (NHWC) output of `dtype`. Float32
+// kernels either compute the values (SIMD when the CPU supports it) or look
+// them up in the per-channel tables, whichever measured faster on this CPU;
+// UInt8 / Int8 kernels look the quantized bytes up, no float is written.
+Model::NormalizeFn select_normalize(PixelFormat src, PixelFormat dst, Layout layout,
+                                    DataType dtype = DataType::Float32);
+
+// Format of the rows the ImageView pipelines hand their kernel, the one to
+// select it for: `src`, except Gray for single channel outputs (3 channel
+// pixels are reduced to luma while resampling, no 3 channel row is formed).
+// 4:2:0 frames always give BGR rows.
+PixelFormat kernel_format(PixelFormat src, int dst_channels);
+
+// Fills `params` for `channels` network channels of mean / norm, tables
+// included, for an input of `dtype` quantized with `quant`. Done once per
+// model, not per image.
+void make_normalize_params(const float* mean, const float* norm, int channels, Model::NormalizeParams& params,
+                           DataType dtype = DataType::Float32, const Quantization& quant = Quantization());
+
+// resize_normalize() with a kernel from select_normalize(). 4:2:0 frames
+// feed the kernel BGR rows, select it for PixelFormat::BGR. Large outputs are
+// split over at most `max_threads` threads (the model's ThreadBudget grant).
+bool resize_normalize(const ImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                      const Model::NormalizeParams& params, const TensorView& dst, int max_threads);
+bool resize_normalize(const YuvImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                      const Model::NormalizeParams& params, const TensorView& dst, int max_threads);
+
+// letterbox_normalize() with a kernel from select_normalize().
+bool letterbox_normalize(const ImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                         const Model::NormalizeParams& params, float pad_value, const TensorView& dst,
+                         InputTransform& transform, int max_threads);
+bool letterbox_normalize(const YuvImageView& src, Model::NormalizeFn normalize, int dst_channels,
+                         const Model::NormalizeParams& params, float pad_value, const TensorView& dst,
+                         InputTransform& transform, int max_threads);
+
+// crop_normalize() with a kernel from select_normalize().
+bool crop_normalize(const ImageView& src, int x, int y, int width, int height, Model::NormalizeFn normalize,
+                    int dst_channels, const Model::NormalizeParams& params, const TensorView& dst,
+                    InputTransform& transform, int max_threads);
+
+// Converts a 4:2:0 frame to packed BGR at its own size, for the paths that
+// need whole 8-bit images (ResizeMode::Pad).
+void yuv_to_bgr(const YuvImageView& src, std::vector<uint8_t>& bgr);
+
+} // namespace mei
+
+#endif // MEI_PREPROCESS_H_
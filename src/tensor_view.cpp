@@ -0,0 +1,222 @@
+#include "mei/tensor_view.h"
+
+#include <cstring>
+
+namespace mei {
+
+size_t dtype_size(DataType dtype) {
+    switch (dtype) {
+    case DataType::Float32: return 4;
+    case DataType::Float16: return 2;
+    case DataType::UInt8: return 1;
+    case DataType::Int8: return 1;
+    case DataType::Int32: return 4;
+    case DataType::Int64: return 8;
+    }
+    return 0;
+}
+
+TensorView TensorView::dense(void* data, const int64_t* shape, int ndim, DataType dtype, Layout layout) {
+    TensorView v;
+    v.data = data;
+    v.dtype = dtype;
+    v.layout = layout;
+    v.ndim = ndim < kMaxDims ? ndim : kMaxDims;
+    int64_t stride = 1;
+    for (int i = v.ndim - 1; i >= 0; i--) {
+        v.shape[i] = shape[i];
+        v.strides[i] = stride;
+        stride *= shape[i];
+    }
+    if (layout == Layout::NC4HW4 && v.ndim == 4) {
+        v.strides[0] = (v.shape[1] + 3) / 4 * 4 * v.shape[2] * v.shape[3];
+    }
+    return v;
+}
+
+int64_t TensorView::element_count() const {
+    int64_t count = 1;
+    for (int i = 0; i < ndim; i++) {
+        count *= shape[i];
+    }
+    return count;
+}
+
+size_t TensorView::storage_bytes() const {
+    int64_t span = 1;
+    for (int i = 0; i < ndim; i++) {
+        if (shape[i] == 0) {
+            return 0;
+        }
+        span += (shape[i] - 1) * strides[i];
+    }
+    if (layout == Layout::NC4HW4 && ndim == 4) {
+        span = shape[0] * strides[0];
+    }
+    return static_cast<size_t>(span) * dtype_size(dtype);
+}
+
+bool TensorView::is_dense() const {
+    if (layout == Layout::NC4HW4) {
+        return false;
+    }
+    int64_t stride = 1;
+    for (int i = ndim - 1; i >= 0; i--) {
+        if (shape[i] != 1 && strides[i] != stride) {
+            return false;
+        }
+        stride *= shape[i];
+    }
+    return true;
+}
+
+namespace {
+
+// Element addressing of a 4D image tensor in logical (n, c, h, w) order.
+struct Addr4 {
+    int64_t n, c, h, w;      // logical extents
+    int64_t sn, sc, sh, sw;  // element strides
+    int64_t c4_plane;        // NC4HW4 only: elements per 4-channel block
+
+    bool init(const TensorView& v) {
+        if (v.ndim != 4) {
+            return false;
+        }
+        switch (v.layout) {
+        case Layout::NCHW:
+            n = v.shape[0]; c = v.shape[1]; h = v.shape[2]; w = v.shape[3];
+            sn = v.strides[0]; sc = v.strides[1]; sh = v.strides[2]; sw = v.strides[3];
+            c4_plane = 0;
+            return true;
+        case Layout::NHWC:
+            n = v.shape[0]; h = v.shape[1]; w = v.shape[2]; c = v.shape[3];
+            sn = v.strides[0]; sh = v.strides[1]; sw = v.strides[2]; sc = v.strides[3];
+            c4_plane = 0;
+            return true;
+        case Layout::NC4HW4:
+            n = v.shape[0]; c = v.shape[1]; h = v.shape[2]; w = v.shape[3];
+            sn = v.strides[0]; sc = 1; sh = w * 4; sw = 4;
+            c4_plane = h * w * 4;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    int64_t channel_offset(int64_t ci) const {
+        return c4_plane ? (ci >> 2) * c4_plane + (ci & 3) : ci * sc;
+    }
+};
+
+template <typename T>
+void copy_rows4(const Addr4& s, const T* src, const Addr4& d, T* dst) {
+    for (int64_t n = 0; n < s.n; n++) {
+        for (int64_t c = 0; c < s.c; c++) {
+            const T* sp = src + n * s.sn + s.channel_offset(c);
+            T* dp = dst + n * d.sn + d.channel_offset(c);
+            for (int64_t h = 0; h < s.h; h++) {
+                const T* sr = sp + h * s.sh;
+                T* dr = dp + h * d.sh;
+                for (int64_t w = 0; w < s.w; w++) {
+                    dr[w * d.sw] = sr[w * s.sw];
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void copy_strided(const TensorView& src, const TensorView& dst) {
+    const T* s = src.ptr<const T>();
+    T* d = dst.ptr<T>();
+    const int nd = src.ndim;
+    int64_t idx[TensorView::kMaxDims] = {};
+    const int64_t inner = nd ? src.shape[nd - 1] : 1;
+    const int64_t s_inner = nd ? src.strides[nd - 1] : 1;
+    const int64_t d_inner = nd ? dst.strides[nd - 1] : 1;
+    const int64_t rows = nd ? src.element_count() / (inner ? inner : 1) : 1;
+    for (int64_t r = 0; r < rows; r++) {
+        int64_t so = 0, doff = 0;
+        for (int i = 0; i < nd - 1; i++) {
+            so += idx[i] * src.strides[i];
+            doff += idx[i] * dst.strides[i];
+        }
+        for (int64_t k = 0; k < inner; k++) {
+            d[doff + k * d_inner] = s[so + k * s_inner];
+        }
+        for (int i = nd - 2; i >= 0; i--) {
+            if (++idx[i] < src.shape[i]) break;
+            idx[i] = 0;
+        }
+    }
+}
+
+template <typename T>
+bool copy_typed(const TensorView& src, const TensorView& dst) {
+    Addr4 s, d;
+    if (src.layout != dst.layout && s.init(src) && d.init(dst)) {
+        if (s.n != d.n || s.c != d.c || s.h != d.h || s.w != d.w) {
+            return false;
+        }
+        copy_rows4<T>(s, src.ptr<const T>(), d, dst.ptr<T>());
+        return true;
+    }
+    if (src.ndim != dst.ndim) {
+        return false;
+    }
+    for (int i = 0; i < src.ndim; i++) {
+        if (src.shape[i] != dst.shape[i]) return false;
+    }
+    if (src.layout == Layout::NC4HW4) {
+        // Same packed layout on both sides, the storage is contiguous.
+        memcpy(dst.data, src.data, src.storage_bytes());
+        return true;
+    }
+    copy_strided<T>(src, dst);
+    return true;
+}
+
+} // namespace
+
+bool copy_tensor(const TensorView& src, const TensorView& dst) {
+    if (src.dtype != dst.dtype) {
+        return false;
+    }
+    if (src.layout == dst.layout && src.is_dense() && dst.is_dense()) {
+        if (src.element_count() != dst.element_count()) {
+            return false;
+        }
+        memcpy(dst.data, src.data, src.element_count() * dtype_size(src.dtype));
+        return true;
+    }
+    switch (dtype_size(src.dtype)) {
+    case 1: return copy_typed<uint8_t>(src, dst);
+    case 2: return copy_typed<uint16_t>(src, dst);
+    case 4: return copy_typed<uint32_t>(src, dst);
+    case 8: return copy_typed<uint64_t>(src, dst);
+    }
+    return false;
+}
+
+bool dequantize(const TensorView& src, float* dst) {
+    if ((src.dtype != DataType::UInt8 && src.dtype != DataType::Int8) || !src.is_dense()) {
+        return false;
+    }
+    const int64_t count = src.element_count();
+    const float scale = src.quant.scale;
+    const int32_t zero_point = src.quant.zero_point;
+    if (src.dtype == DataType::UInt8) {
+        const uint8_t* q = src.ptr<const uint8_t>();
+        for (int64_t i = 0; i < count; i++) {
+            dst[i] = static_cast<float>(q[i] - zero_point) * scale;
+        }
+    } else {
+        const int8_t* q = src.ptr<const int8_t>();
+        for (int64_t i = 0; i < count; i++) {
+            dst[i] = static_cast<float>(q[i] - zero_point) * scale;
+        }
+    }
+    return true;
+}
+
+} // namespace mei
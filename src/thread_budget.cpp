@@ -0,0 +1,115 @@
+#include "mei/thread_budget.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#include "mei/engine.h"
+
+namespace mei {
+
+ThreadBudget& ThreadBudget::instance() {
+    static ThreadBudget budget;
+    return budget;
+}
+
+ThreadBudget::ThreadBudget() {
+    const char* env = getenv("MEI_THREAD_BUDGET");
+    total_ = env ? atoi(env) : 0;
+    if (total_ <= 0) {
+        total_ = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+}
+
+void ThreadBudget::set_total(int cores) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_ = std::max(cores, 1);
+    rebalance_locked(nullptr);
+}
+
+int ThreadBudget::total() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+void ThreadBudget::set_pinning(bool pin) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pin_ = pin;
+    rebalance_locked(nullptr);
+}
+
+bool ThreadBudget::pinning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pin_;
+}
+
+ThreadGrant ThreadBudget::attach(Engine* engine, int requested) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    members_.push_back(Member{engine, std::max(requested, 1), ThreadGrant()});
+    rebalance_locked(engine);
+    return members_.back().grant;
+}
+
+void ThreadBudget::detach(Engine* engine) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(members_.begin(), members_.end(), [engine](const Member& m) { return m.engine == engine; });
+    if (it == members_.end()) {
+        return;
+    }
+    members_.erase(it);
+    rebalance_locked(nullptr);
+}
+
+void ThreadBudget::rebalance_locked(const Engine* joining) {
+    // Water filling: requests at or under the equal share are granted as is,
+    // the remaining engines split what they leave over.
+    const size_t n = members_.size();
+    std::vector<int> threads(n, 0);
+    int remaining = total_;
+    size_t open = n;
+    bool settled = false;
+    while (open > 0 && !settled) {
+        settled = true;
+        const int share = std::max(remaining / static_cast<int>(open), 1);
+        for (size_t i = 0; i < n; i++) {
+            if (threads[i] == 0 && members_[i].requested <= share) {
+                threads[i] = members_[i].requested;
+                remaining -= threads[i];
+                open--;
+                settled = false;
+            }
+        }
+    }
+    if (open > 0) {
+        const int share = std::max(remaining / static_cast<int>(open), 1);
+        int extra = std::max(remaining - share * static_cast<int>(open), 0);
+        for (size_t i = 0; i < n; i++) {
+            if (threads[i] == 0) {
+                threads[i] = share + (extra > 0 ? 1 : 0);
+                extra--;
+            }
+        }
+    }
+
+    // Consecutive core ranges in join order, wrapping when oversubscribed.
+    int next_cpu = 0;
+    for (size_t i = 0; i < n; i++) {
+        ThreadGrant grant;
+        grant.num_threads = threads[i];
+        if (pin_) {
+            for (int t = 0; t < threads[i]; t++) {
+                grant.cpus.push_back((next_cpu + t) % total_);
+            }
+        }
+        next_cpu = (next_cpu + threads[i]) % total_;
+
+        Member& m = members_[i];
+        const bool changed = grant.num_threads != m.grant.num_threads || grant.cpus != m.grant.cpus;
+        m.grant = grant;
+        if (changed && m.engine != joining) {
+            m.engine->post_thread_grant(grant);
+        }
+    }
+}
+
+} // namespace mei
@@ -0,0 +1,88 @@
+#include "mei/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace mei {
+
+ThreadPool::ThreadPool(int num_threads) {
+    for (int i = 0; i < std::max(num_threads, 1); i++) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& fn) {
+    struct State {
+        std::atomic<int> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        int done = 0;
+    };
+    // Helpers that start after the last index was taken only touch the state.
+    std::shared_ptr<State> state = std::make_shared<State>();
+    const std::function<void(int)>* body = &fn;
+    auto run = [state, body, count] {
+        int finished = 0;
+        for (int i = state->next++; i < count; i = state->next++) {
+            (*body)(i);
+            finished++;
+        }
+        if (finished > 0) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->done += finished;
+            if (state->done == count) {
+                state->cv.notify_all();
+            }
+        }
+    };
+    const int helpers = std::min(count - 1, size());
+    for (int i = 0; i < helpers; i++) {
+        enqueue(run);
+    }
+    run();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done == count; });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace mei